@@ -41,10 +41,12 @@ namespace klex
             return MAX_SIZE;
         }
 
-        void push_back(int cp)
+        // end_offset is the position in the input right after cp.
+        void push_back(int cp, std::uint64_t end_offset = 0)
         {
             assert(size() < max_size());
             data_[end_] = cp;
+            offsets_[end_] = end_offset;
             ++end_;
         }
 
@@ -60,10 +62,29 @@ namespace klex
             return data_[begin_];
         }
 
+        void clear()
+        {
+            begin_ = end_ = 0;
+        }
+
+        // Moves the end offset of the last code point past input that
+        // was consumed without producing a code point of its own.
+        void set_back_offset(std::uint64_t end_offset)
+        {
+            assert(!empty());
+            offsets_[static_cast<std::uint8_t>(end_ - 1)] = end_offset;
+        }
+
+        std::uint64_t front_offset() const
+        {
+            assert(!empty());
+            return offsets_[begin_];
+        }
+
         int operator[](std::uint8_t index) const
         {
             assert(index < size());
-            return data_[begin_ + index];
+            return data_[static_cast<std::uint8_t>(begin_ + index)];
         }
 
     private:
@@ -73,6 +94,7 @@ namespace klex
         std::uint8_t begin_ = 0;
         std::uint8_t end_ = 0;
         int data_[MAX_SIZE + 1];
+        std::uint64_t offsets_[MAX_SIZE + 1];
     };
 
 } // close klex namespace
@@ -0,0 +1,94 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "DecompressingStreamBuf.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace klex
+{
+
+    DecompressingStreamBuf::DecompressingStreamBuf(
+        std::unique_ptr<std::istream>&& compressed)
+    : compressed_{std::move(compressed)}
+    , input_(BLOCK_SIZE)
+    , input_pos_{0}
+    , input_end_{0}
+    , output_{}
+    {
+    }
+
+    char const* DecompressingStreamBuf::input_data() const
+    {
+        return input_.data() + input_pos_;
+    }
+
+    std::size_t DecompressingStreamBuf::input_size() const
+    {
+        return input_end_ - input_pos_;
+    }
+
+    void DecompressingStreamBuf::consume_input(std::size_t size)
+    {
+        assert(size <= input_size());
+        input_pos_ += size;
+    }
+
+    bool DecompressingStreamBuf::read_input()
+    {
+        if (input_pos_ == input_end_)
+        {
+            compressed_->read(input_.data(), input_.size());
+            input_pos_ = 0;
+            input_end_ = compressed_->gcount();
+        }
+        return input_pos_ != input_end_;
+    }
+
+    DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow()
+    {
+        if (output_.empty())
+        {
+            output_.resize(BLOCK_SIZE);
+        }
+        std::size_t size = decompress(output_.data(), output_.size());
+        if (size == 0)
+        {
+            return traits_type::eof();
+        }
+        setg(output_.data(), output_.data(), output_.data() + size);
+        return traits_type::to_int_type(output_[0]);
+    }
+
+    std::streamsize DecompressingStreamBuf::xsgetn(char* s, std::streamsize n)
+    {
+        // drain the get area first so that the order of bytes is preserved
+        std::streamsize count = std::min<std::streamsize>(n, egptr() - gptr());
+        std::copy(gptr(), gptr() + count, s);
+        gbump(static_cast<int>(count));
+        while (count < n)
+        {
+            std::size_t size = decompress(s + count, n - count);
+            if (size == 0)
+            {
+                break;
+            }
+            count += size;
+        }
+        return count;
+    }
+
+} // close klex namespace
@@ -0,0 +1,89 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DECOMPRESSINGSTREAMBUF_H_INCLUDED_8MUE4FQB
+#define DECOMPRESSINGSTREAMBUF_H_INCLUDED_8MUE4FQB
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <utility>
+#include <vector>
+
+namespace klex
+{
+
+    // Base class for stream buffers which decompress another stream. Bulk
+    // reads, such as the ones done by InputStream, are decompressed
+    // straight into the caller's buffer.
+    class DecompressingStreamBuf : public std::streambuf
+    {
+    public:
+        explicit DecompressingStreamBuf(
+            std::unique_ptr<std::istream>&& compressed);
+
+    protected:
+        // Decompresses up to size bytes into out. Returns 0 at the end of
+        // input and throws std::runtime_error if the input is corrupt.
+        virtual std::size_t decompress(char* out, std::size_t size) = 0;
+
+        // Compressed bytes not consumed yet.
+        char const* input_data() const;
+
+        std::size_t input_size() const;
+
+        void consume_input(std::size_t size);
+
+        // Reads more compressed bytes if there are none left. Returns
+        // false at the end of the compressed stream.
+        bool read_input();
+
+        int_type underflow() override;
+
+        std::streamsize xsgetn(char* s, std::streamsize n) override;
+
+    private:
+        static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+        std::unique_ptr<std::istream> compressed_;
+        std::vector<char> input_;
+        std::size_t input_pos_;
+        std::size_t input_end_;
+        // backs the get area for character-wise reads
+        std::vector<char> output_;
+    };
+
+    // An istream that owns its decompressing stream buffer. Decompression
+    // errors are propagated as exceptions rather than just setting badbit.
+    template <typename StreamBuf>
+    class DecompressingStream : public std::istream
+    {
+    public:
+        explicit DecompressingStream(std::unique_ptr<std::istream>&& compressed)
+        : std::istream{nullptr}
+        , buffer_{std::move(compressed)}
+        {
+            rdbuf(&buffer_);
+            exceptions(std::ios::badbit);
+        }
+
+    private:
+        StreamBuf buffer_;
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,35 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ENCODING_H_INCLUDED_R3KQ8ZTM
+#define ENCODING_H_INCLUDED_R3KQ8ZTM
+
+namespace klex
+{
+
+    enum class Encoding
+    {
+        utf8,
+        utf16le,
+        utf16be,
+        latin1,
+        // Picks UTF-8, UTF-16LE or UTF-16BE based on the byte order mark
+        // and skips it; falls back to UTF-8 when there is none.
+        detect
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,94 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "GzipStreamBuf.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace klex
+{
+
+    namespace
+    {
+
+        void throw_error(z_stream const& stream, char const* what)
+        {
+            throw std::runtime_error(std::string("GzipStreamBuf: ") +
+                                     (stream.msg ? stream.msg : what));
+        }
+
+    } // close unnamed namespace
+
+    GzipStreamBuf::GzipStreamBuf(std::unique_ptr<std::istream>&& compressed)
+    : DecompressingStreamBuf{std::move(compressed)}
+    , stream_{}
+    , member_end_{false}
+    {
+        // 32 enables automatic gzip/zlib header detection
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK)
+        {
+            throw_error(stream_, "cannot initialize zlib");
+        }
+    }
+
+    GzipStreamBuf::~GzipStreamBuf()
+    {
+        inflateEnd(&stream_);
+    }
+
+    std::size_t GzipStreamBuf::decompress(char* out, std::size_t size)
+    {
+        size = std::min<std::size_t>(size, std::numeric_limits<uInt>::max());
+        stream_.next_out = reinterpret_cast<Bytef*>(out);
+        stream_.avail_out = static_cast<uInt>(size);
+        while (stream_.avail_out == size)
+        {
+            bool const more_input = read_input();
+            if (!more_input && member_end_)
+            {
+                break;
+            }
+            if (member_end_)
+            {
+                inflateReset(&stream_);
+                member_end_ = false;
+            }
+            stream_.next_in =
+                reinterpret_cast<Bytef*>(const_cast<char*>(input_data()));
+            stream_.avail_in = static_cast<uInt>(
+                std::min<std::size_t>(input_size(),
+                                      std::numeric_limits<uInt>::max()));
+            uInt const avail_in = stream_.avail_in;
+            int result = inflate(&stream_, Z_NO_FLUSH);
+            consume_input(avail_in - stream_.avail_in);
+            if (result == Z_STREAM_END)
+            {
+                member_end_ = true;
+            }
+            else if (result != Z_OK && result != Z_BUF_ERROR)
+            {
+                throw_error(stream_, "corrupt input");
+            }
+            else if (!more_input && stream_.avail_out == size)
+            {
+                throw_error(stream_, "truncated input");
+            }
+        }
+        return size - stream_.avail_out;
+    }
+
+} // close klex namespace
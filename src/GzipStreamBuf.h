@@ -0,0 +1,49 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GZIPSTREAMBUF_H_INCLUDED_KX3R5NWD
+#define GZIPSTREAMBUF_H_INCLUDED_KX3R5NWD
+
+#include "DecompressingStreamBuf.h"
+#include <zlib.h>
+
+namespace klex
+{
+
+    // Decompresses gzip or zlib data, including concatenated gzip members.
+    // Only available if klex was built with zlib (KLEX_HAVE_ZLIB).
+    class GzipStreamBuf : public DecompressingStreamBuf
+    {
+    public:
+        explicit GzipStreamBuf(std::unique_ptr<std::istream>&& compressed);
+
+        ~GzipStreamBuf();
+
+        GzipStreamBuf(GzipStreamBuf const&) = delete;
+        GzipStreamBuf& operator=(GzipStreamBuf const&) = delete;
+
+    protected:
+        std::size_t decompress(char* out, std::size_t size) override;
+
+    private:
+        z_stream stream_;
+        bool member_end_;
+    };
+
+    typedef DecompressingStream<GzipStreamBuf> GzipStream;
+
+} // close klex namespace
+
+#endif // include guard
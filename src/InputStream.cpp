@@ -14,7 +14,12 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "InputStream.h"
+#include "Latin1Decoder.h"
+#include "LocationTable.h"
+#include "Utf16Decoder.h"
 #include "Utf8Decoder.h"
+#include <algorithm>
+#include <limits>
 #include <utility>
 #include <stdexcept>
 #include <cassert>
@@ -22,29 +27,95 @@
 namespace klex
 {
 
-    InputStream::InputStream(std::unique_ptr<std::istream>&& stream)
+    InputStream::InputStream(std::unique_ptr<std::istream>&& stream,
+                             Encoding encoding)
     : stream_{std::move(stream)}
+    , source_{}
+    , initial_encoding_{encoding}
+    , encoding_{encoding}
     , buffer_{}
+    , chunk_{}
+    , begin_{nullptr}
+    , pos_{nullptr}
+    , valid_end_{nullptr}
+    , end_{nullptr}
+    , stream_end_{false}
+    , chunk_offset_{0}
+    , offset_{0}
+    , position_{0}
     , line_{1}
     , column_{1}
     , ignore_line_feed_{false}
+    , state_{0}
+    , snapshot_interval_{0}
+    , snapshots_{Snapshot{0, 0, 1, 1, 0}}
+    , next_kept_{1}
+    , kept_reached_{false}
+    , synchronized_{false}
+    , invalid_sequences_{}
+    , next_kept_invalid_{0}
+    , location_table_{nullptr}
+    , file_{0}
+    , location_start_{0}
+    , location_size_{0}
+    , pending_lines_{}
+    , first_pending_line_{2}
     {
     }
 
+    InputStream::InputStream(std::shared_ptr<SourceFile const> source,
+                             Encoding encoding)
+    : InputStream{std::unique_ptr<std::istream>{}, encoding}
+    {
+        open(std::move(source), 0);
+    }
+
+    InputStream::~InputStream()
+    {
+        if (location_table_)
+        {
+            publish_lines(!kept_reached_);
+        }
+    }
+
     int InputStream::get()
     {
         populate_buffer(1);
         int code_point = buffer_.front();
+        offset_ = buffer_.front_offset();
         buffer_.pop_front();
         if (code_point == '\n')
         {
+            ++position_;
             ++line_;
             column_ = 1;
+            if (location_table_ && line_ >= first_pending_line_)
+            {
+                pending_lines_.push_back(position_);
+            }
+            take_snapshot();
+            if (pending_lines_.size() >= LINE_BATCH_SIZE && !is_catching_up())
+            {
+                publish_lines(!kept_reached_);
+            }
         }
         else if (code_point != EOF)
         {
+            ++position_;
             ++column_;
         }
+        else
+        {
+            // kept snapshots that were never reached lie past the end
+            snapshots_.erase(snapshots_.begin() + next_kept_,
+                             snapshots_.end());
+            drop_kept_invalid_sequences(
+                std::numeric_limits<std::uint64_t>::max());
+            if (location_table_)
+            {
+                publish_lines(true);
+            }
+        }
         return code_point;
     }
 
@@ -64,32 +135,595 @@ namespace klex
         return column_;
     }
 
+    std::uint64_t InputStream::get_offset() const
+    {
+        return offset_;
+    }
+
+    std::uint64_t InputStream::get_position() const
+    {
+        return position_;
+    }
+
+    std::vector<InputStream::InvalidSequence> const&
+    InputStream::get_invalid_sequences() const
+    {
+        return invalid_sequences_;
+    }
+
+    SourceLocation InputStream::get_location() const
+    {
+        return get_location(position_);
+    }
+
+    SourceLocation InputStream::get_location(std::uint64_t position) const
+    {
+        if (file_ == 0)
+        {
+            return SourceLocation{};
+        }
+        if (position > location_size_)
+        {
+            throw std::out_of_range(
+                "InputStream: position past end of location table file");
+        }
+        return SourceLocation{location_start_ +
+                              static_cast<std::uint32_t>(position)};
+    }
+
+    void InputStream::set_location_table(LocationTable& table,
+                                         SourceLocation::FileId file)
+    {
+        location_table_ = &table;
+        file_ = file;
+        location_start_ = table.get_location(file, 0).get_raw();
+        location_size_ = table.get_file_size(file);
+        if (source_ && initial_encoding_ == Encoding::utf8 && position_ == 0 &&
+            snapshots_.size() == 1)
+        {
+            // the file has indexed its lines already, so publish them all
+            // at once; get() leaves the lines before first_pending_line_
+            // alone
+            std::vector<std::uint64_t> const& starts =
+                source_->get_line_starts();
+            table.replace_lines(file, 2, std::numeric_limits<int>::max(),
+                                starts, 0);
+            pending_lines_.clear();
+            first_pending_line_ = static_cast<int>(starts.size()) + 2;
+        }
+    }
+
+    void InputStream::set_state(int state)
+    {
+        state_ = state;
+    }
+
+    int InputStream::get_state() const
+    {
+        return state_;
+    }
+
+    void InputStream::set_snapshot_interval(int num_lines)
+    {
+        assert(num_lines >= 0);
+        snapshot_interval_ = num_lines;
+    }
+
+    std::vector<InputStream::Snapshot> const& InputStream::get_snapshots() const
+    {
+        return snapshots_;
+    }
+
+    bool InputStream::is_synchronized() const
+    {
+        return synchronized_;
+    }
+
+    InputStream::Snapshot
+    InputStream::resume(std::unique_ptr<std::istream>&& stream,
+                        std::uint64_t edit_offset, std::uint64_t old_length,
+                        std::uint64_t new_length)
+    {
+        if (location_table_ && !is_catching_up())
+        {
+            publish_lines(!kept_reached_);
+        }
+        Snapshot const snapshot = rewind(edit_offset, old_length, new_length);
+        source_.reset();
+        stream_ = std::move(stream);
+        if (!stream_->seekg(snapshot.offset))
+        {
+            throw std::runtime_error("InputStream: cannot seek to snapshot");
+        }
+        begin_ = pos_ = valid_end_ = end_ = chunk_.data();
+        stream_end_ = false;
+        chunk_offset_ = snapshot.offset;
+        return snapshot;
+    }
+
+    InputStream::Snapshot
+    InputStream::resume(std::shared_ptr<SourceFile const> source,
+                        std::uint64_t edit_offset, std::uint64_t old_length,
+                        std::uint64_t new_length)
+    {
+        if (location_table_ && !is_catching_up())
+        {
+            publish_lines(!kept_reached_);
+        }
+        Snapshot const snapshot = rewind(edit_offset, old_length, new_length);
+        open(std::move(source), snapshot.offset);
+        return snapshot;
+    }
+
+    void InputStream::take_snapshot()
+    {
+        // kept snapshots that get() has gone past are no longer line starts
+        auto first = snapshots_.begin() + next_kept_;
+        auto last = first;
+        while (last != snapshots_.end() && last->offset < offset_)
+        {
+            ++last;
+        }
+        auto kept = snapshots_.erase(first, last);
+        drop_kept_invalid_sequences(decoded_offset());
+
+        if (kept != snapshots_.end() && kept->offset == offset_)
+        {
+            // the input past the edit is unchanged, so the kept snapshots
+            // are all off by the same number of lines and code points
+            std::uint64_t const position_delta = position_ - kept->position;
+            int const line_delta = line_ - kept->line;
+            if (location_table_ && !kept_reached_)
+            {
+                // splice the relexed lines into those of the previous pass
+                location_table_->replace_lines(
+                    file_, first_pending_line_, kept->line + 1,
+                    pending_lines_,
+                    static_cast<std::int64_t>(position_delta));
+                pending_lines_.clear();
+                first_pending_line_ = line_ + 1;
+            }
+            if (position_delta != 0 || line_delta != 0)
+            {
+                for (auto it = kept; it != snapshots_.end(); ++it)
+                {
+                    it->position += position_delta;
+                    it->line += line_delta;
+                }
+            }
+            synchronized_ = kept->state == state_;
+            kept_reached_ = true;
+            ++next_kept_;
+        }
+        else if (snapshot_interval_ != 0 &&
+                 (line_ - 1) % snapshot_interval_ == 0 &&
+                 (!kept_reached_ || kept == snapshots_.end()))
+        {
+            // once a kept snapshot has been reached the ones after it
+            // already cover the unchanged input
+            snapshots_.insert(kept, Snapshot{offset_, position_, line_,
+                                             column_, state_});
+            ++next_kept_;
+        }
+    }
+
+    bool InputStream::is_catching_up() const
+    {
+        // between resume() and the first kept snapshot the new line starts
+        // cannot be published without knowing which old ones they replace
+        return next_kept_ != snapshots_.size() && !kept_reached_;
+    }
+
+    void InputStream::publish_lines(bool truncate)
+    {
+        if (pending_lines_.empty() && !truncate)
+        {
+            return;
+        }
+        int const end_line =
+            truncate ? std::numeric_limits<int>::max()
+                     : first_pending_line_ +
+                           static_cast<int>(pending_lines_.size());
+        location_table_->replace_lines(file_, first_pending_line_, end_line,
+                                       pending_lines_, 0);
+        first_pending_line_ += static_cast<int>(pending_lines_.size());
+        pending_lines_.clear();
+    }
+
+    InputStream::Snapshot InputStream::rewind(std::uint64_t edit_offset,
+                                              std::uint64_t old_length,
+                                              std::uint64_t new_length)
+    {
+        auto by_offset = [](Snapshot const& snapshot, std::uint64_t offset)
+        {
+            return snapshot.offset < offset;
+        };
+        auto it = std::lower_bound(snapshots_.begin(), snapshots_.end(),
+                                   edit_offset, by_offset);
+        if (it != snapshots_.begin())
+        {
+            --it;
+        }
+        if (!kept_reached_ &&
+            static_cast<std::size_t>(it - snapshots_.begin()) >= next_kept_)
+        {
+            // kept snapshots have stale lines and positions until the first
+            // of them is reached
+            it = snapshots_.begin() + (next_kept_ - 1);
+        }
+        Snapshot const snapshot = *it;
+        // a snapshot right at the end of the edit follows an edited byte
+        // and may no longer start a line, so only later ones are kept
+        std::uint64_t const edit_end = edit_offset + old_length;
+        auto kept = std::lower_bound(it + 1, snapshots_.end(), edit_end + 1,
+                                     by_offset);
+        for (auto k = kept; k != snapshots_.end(); ++k)
+        {
+            k->offset = k->offset - old_length + new_length;
+        }
+        snapshots_.erase(it + 1, kept);
+        next_kept_ = (it - snapshots_.begin()) + 1;
+        kept_reached_ = false;
+        synchronized_ = false;
+
+        auto invalid_first = std::lower_bound(
+            invalid_sequences_.begin(), invalid_sequences_.end(),
+            snapshot.offset,
+            [](InvalidSequence const& sequence, std::uint64_t offset)
+            {
+                return sequence.offset < offset;
+            });
+        auto invalid_last = invalid_first;
+        while (invalid_last != invalid_sequences_.end() &&
+               invalid_last->offset < edit_end)
+        {
+            ++invalid_last;
+        }
+        for (auto k = invalid_last; k != invalid_sequences_.end(); ++k)
+        {
+            k->offset = k->offset - old_length + new_length;
+        }
+        next_kept_invalid_ = invalid_first - invalid_sequences_.begin();
+        invalid_sequences_.erase(invalid_first, invalid_last);
+
+        if (snapshot.offset == 0)
+        {
+            encoding_ = initial_encoding_;
+        }
+        buffer_.clear();
+        offset_ = snapshot.offset;
+        position_ = snapshot.position;
+        line_ = snapshot.line;
+        column_ = snapshot.column;
+        state_ = snapshot.state;
+        // snapshots are taken after the line feed of a CRLF
+        ignore_line_feed_ = false;
+        // lines up to the restored one are still valid; those past the
+        // pending ones were published by an earlier pass
+        if (snapshot.line < first_pending_line_ ||
+            static_cast<std::size_t>(snapshot.line - first_pending_line_) >=
+                pending_lines_.size())
+        {
+            pending_lines_.clear();
+            first_pending_line_ = snapshot.line + 1;
+        }
+        else
+        {
+            pending_lines_.resize(snapshot.line - first_pending_line_ + 1);
+        }
+        return snapshot;
+    }
+
+    void InputStream::open(std::shared_ptr<SourceFile const>&& source,
+                           std::uint64_t offset)
+    {
+        if (offset > source->size())
+        {
+            throw std::runtime_error("InputStream: offset past end of file");
+        }
+        source_ = std::move(source);
+        stream_.reset();
+        begin_ = source_->data();
+        end_ = begin_ + source_->size();
+        pos_ = begin_ + offset;
+        stream_end_ = true;
+        chunk_offset_ = 0;
+        valid_end_ = find_valid_end();
+    }
+
     void InputStream::populate_buffer(std::uint8_t num)
     {
         assert(num < buffer_.max_size());
-        Utf8Decoder decoder;
         while (num >= buffer_.size())
         {
-            int code_point = decoder.decode(*stream_);
-            if (code_point == '\r')
+            if (!transcode_run())
+            {
+                push_code_point(decode());
+            }
+        }
+    }
+
+    void InputStream::push_code_point(int code_point)
+    {
+        // CR, LF and CRLF all become a single line feed whose end offset
+        // is past the whole newline
+        if (code_point == '\r')
+        {
+            buffer_.push_back('\n', decoded_offset());
+            ignore_line_feed_ = true;
+        }
+        else if (code_point == '\n')
+        {
+            if (ignore_line_feed_)
             {
-                buffer_.push_back('\n');
-                ignore_line_feed_ = true;
+                buffer_.set_back_offset(decoded_offset());
             }
-            else if (code_point == '\n')
+            else
             {
-                if (!ignore_line_feed_)
+                buffer_.push_back(code_point, decoded_offset());
+            }
+            ignore_line_feed_ = false;
+        }
+        else
+        {
+            buffer_.push_back(code_point, decoded_offset());
+            ignore_line_feed_ = false;
+        }
+    }
+
+    bool InputStream::transcode_run()
+    {
+        // Every Latin-1 byte and every UTF-16 code unit outside the
+        // surrogate range is a code point of its own, so runs of them are
+        // copied straight into the buffer until it is full, stopping only
+        // at a surrogate. Anything else, including refills, goes through
+        // decode().
+        char const* const start = pos_;
+        std::size_t const room = buffer_.max_size() - buffer_.size();
+        if (encoding_ == Encoding::latin1)
+        {
+            char const* const end =
+                pos_ + std::min<std::size_t>(room, end_ - pos_);
+            while (pos_ != end)
+            {
+                int const code_point = static_cast<unsigned char>(*pos_++);
+                push_code_point(code_point);
+            }
+        }
+        else if (encoding_ == Encoding::utf16le ||
+                 encoding_ == Encoding::utf16be)
+        {
+            Utf16Decoder const decoder{encoding_ == Encoding::utf16be};
+            char const* const end =
+                pos_ + std::min<std::size_t>(room, (end_ - pos_) / 2) * 2;
+            while (pos_ != end)
+            {
+                int const code_point = decoder.code_unit(pos_);
+                if ((code_point & 0xF800) == 0xD800)
                 {
-                    buffer_.push_back(code_point);
+                    break;
                 }
-                ignore_line_feed_ = false;
+                pos_ += 2;
+                push_code_point(code_point);
             }
-            else
+        }
+        return pos_ != start;
+    }
+
+    int InputStream::decode()
+    {
+        Utf8Decoder decoder;
+        if (pos_ < valid_end_)
+        {
+            return decoder.decode_unchecked(pos_);
+        }
+        if (!stream_end_ &&
+            static_cast<std::size_t>(end_ - pos_) < bytes_needed())
+        {
+            do
+            {
+                refill();
+            } while (!stream_end_ &&
+                     static_cast<std::size_t>(end_ - pos_) < bytes_needed());
+            if (pos_ < valid_end_)
+            {
+                return decoder.decode_unchecked(pos_);
+            }
+        }
+
+        char const* const start = pos_;
+        int code_point = EOF;
+        switch (encoding_)
+        {
+        case Encoding::utf8:
+            // Ill-formed input or end of stream - take the checked path and
+            // validate whatever follows it.
+            code_point = decoder.decode(pos_, end_);
+            valid_end_ = find_valid_end();
+            break;
+        case Encoding::utf16le:
+            code_point = Utf16Decoder{false}.decode(pos_, end_);
+            break;
+        case Encoding::utf16be:
+            code_point = Utf16Decoder{true}.decode(pos_, end_);
+            break;
+        case Encoding::latin1:
+            code_point = Latin1Decoder{}.decode(pos_, end_);
+            break;
+        case Encoding::detect:
+            detect_encoding();
+            return decode();
+        }
+        if (code_point == Utf8Decoder::INVALID &&
+            is_invalid_sequence(start, pos_))
+        {
+            add_invalid_sequence(InvalidSequence{
+                chunk_offset_ + (start - begin_),
+                static_cast<std::uint32_t>(pos_ - start)});
+        }
+        return code_point;
+    }
+
+    void InputStream::add_invalid_sequence(InvalidSequence const& sequence)
+    {
+        drop_kept_invalid_sequences(sequence.offset);
+        auto it = invalid_sequences_.begin() + next_kept_invalid_;
+        if (it != invalid_sequences_.end() && it->offset == sequence.offset)
+        {
+            *it = sequence;
+        }
+        else
+        {
+            invalid_sequences_.insert(it, sequence);
+        }
+        ++next_kept_invalid_;
+    }
+
+    void InputStream::drop_kept_invalid_sequences(std::uint64_t offset)
+    {
+        // kept sequences that decoding has gone past without finding them
+        // again were made valid by the edit
+        auto first = invalid_sequences_.begin() + next_kept_invalid_;
+        auto last = first;
+        while (last != invalid_sequences_.end() && last->offset < offset)
+        {
+            ++last;
+        }
+        invalid_sequences_.erase(first, last);
+    }
+
+    void InputStream::refill()
+    {
+        chunk_offset_ = decoded_offset();
+        std::size_t const remaining = end_ - pos_;
+        if (chunk_.empty())
+        {
+            chunk_.resize(CHUNK_SIZE);
+        }
+        std::copy(pos_, end_, chunk_.begin());
+        char* const free = chunk_.data() + remaining;
+        std::size_t const wanted = chunk_.size() - remaining;
+        // Take whatever the stream has at hand and only block for a single
+        // byte if it has nothing, so that input from a pipe or terminal is
+        // lexed as soon as it arrives.
+        std::streamsize const available = stream_->rdbuf()->in_avail();
+        std::size_t count;
+        if (available > 0)
+        {
+            stream_->read(free, std::min<std::size_t>(available, wanted));
+            count = stream_->gcount();
+        }
+        else
+        {
+            stream_->read(free, 1);
+            count = stream_->gcount();
+            stream_end_ = count == 0;
+            if (count != 0)
+            {
+                count += stream_->readsome(free + 1, wanted - 1);
+            }
+        }
+        begin_ = pos_ = chunk_.data();
+        end_ = pos_ + remaining + count;
+        valid_end_ = find_valid_end();
+    }
+
+    std::size_t InputStream::bytes_needed() const
+    {
+        // bytes that have to be at hand before the code point at pos_ can
+        // be decoded without mistaking a partial read for a truncation
+        std::size_t const available = end_ - pos_;
+        switch (encoding_)
+        {
+        case Encoding::utf8:
+        {
+            if (available == 0)
+            {
+                return 1;
+            }
+            unsigned char const lead = *pos_;
+            return lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        }
+        case Encoding::utf16le:
+        case Encoding::utf16be:
+            if (available < 2)
             {
-                buffer_.push_back(code_point);
-                ignore_line_feed_ = false;
+                return 2;
             }
+            return (Utf16Decoder{encoding_ == Encoding::utf16be}.code_unit(
+                        pos_) & 0xFC00) == 0xD800 ? 4 : 2;
+        case Encoding::latin1:
+            return 1;
+        case Encoding::detect:
+            // the longest byte order mark
+            return 3;
+        }
+        return 1;
+    }
+
+    char const* InputStream::find_valid_end() const
+    {
+        if (encoding_ != Encoding::utf8)
+        {
+            return pos_;
+        }
+        if (source_)
+        {
+            // any suffix of the validated prefix is valid as well
+            char const* valid_end = source_->data() + source_->get_valid_size();
+            if (pos_ < valid_end)
+            {
+                return valid_end;
+            }
+        }
+        return Utf8Decoder::validate(pos_, end_);
+    }
+
+    bool InputStream::is_invalid_sequence(char const* begin,
+                                          char const* end) const
+    {
+        // tells a decoding error from a genuine U+FFFD in the input
+        switch (encoding_)
+        {
+        case Encoding::utf8:
+            return end - begin != 3 || begin[0] != '\xEF';
+        case Encoding::utf16le:
+            return end - begin != 2 || (begin[1] & 0xF8) == 0xD8;
+        case Encoding::utf16be:
+            return end - begin != 2 || (begin[0] & 0xF8) == 0xD8;
+        default:
+            return false;
+        }
+    }
+
+    std::uint64_t InputStream::decoded_offset() const
+    {
+        return chunk_offset_ + (pos_ - begin_);
+    }
+
+    void InputStream::detect_encoding()
+    {
+        auto starts_with = [this](char const* bom, std::size_t length)
+        {
+            return static_cast<std::size_t>(end_ - pos_) >= length &&
+                   std::equal(bom, bom + length, pos_);
+        };
+        encoding_ = Encoding::utf8;
+        if (starts_with("\xEF\xBB\xBF", 3))
+        {
+            pos_ += 3;
+        }
+        else if (starts_with("\xFF\xFE", 2))
+        {
+            encoding_ = Encoding::utf16le;
+            pos_ += 2;
+        }
+        else if (starts_with("\xFE\xFF", 2))
+        {
+            encoding_ = Encoding::utf16be;
+            pos_ += 2;
         }
+        valid_end_ = find_valid_end();
     }
 
 } // close klex namespace
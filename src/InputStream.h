@@ -17,6 +17,10 @@
 #define INPUTSTREAM_H_INCLUDED_8YDFSC1N
 
 #include "CodePointBuffer.h"
+#include "Encoding.h"
+#include "SourceFile.h"
+#include "SourceLocation.h"
+#include <cstddef>
 #include <cstdint>
 #include <istream>
 #include <memory>
@@ -25,10 +29,38 @@
 namespace klex
 {
 
+    class LocationTable;
+
     class InputStream
     {
     public:
-        explicit InputStream(std::unique_ptr<std::istream>&& stream);
+        // A point at the start of a line from which decoding can be resumed.
+        // Offsets are in bytes from the beginning of the stream.
+        struct Snapshot
+        {
+            std::uint64_t offset;
+            std::uint64_t position;
+            int line;
+            int column;
+            int state;
+        };
+
+        // Ill-formed input that was decoded as Utf8Decoder::INVALID.
+        struct InvalidSequence
+        {
+            std::uint64_t offset;
+            std::uint32_t length;
+        };
+
+    public:
+        explicit InputStream(std::unique_ptr<std::istream>&& stream,
+                             Encoding encoding = Encoding::utf8);
+
+        // Reads the contents of source in place, without copying them.
+        explicit InputStream(std::shared_ptr<SourceFile const> source,
+                             Encoding encoding = Encoding::utf8);
+
+        ~InputStream();
 
         int get();
 
@@ -38,15 +70,149 @@ namespace klex
 
         int get_column() const;
 
+        // Byte offset of the next code point returned by get(). A line feed
+        // following a carriage return is counted as part of the newline.
+        std::uint64_t get_offset() const;
+
+        // Number of code points before the next one returned by get().
+        std::uint64_t get_position() const;
+
+        // Location of the next code point returned by get(). Invalid unless
+        // a location table has been set; throws std::out_of_range once the
+        // input is longer than the size the file was added with.
+        SourceLocation get_location() const;
+
+        // Location of the code point at the given position. Reads only what
+        // set_location_table() set, so it is safe to call while another
+        // thread is calling get().
+        SourceLocation get_location(std::uint64_t position) const;
+
+        // Makes the stream record line starts of the given file in table,
+        // which must outlive the stream. The file must have been added with
+        // a size of at least the number of code points in the stream. Line
+        // starts are published in batches, at the end of input, on resume()
+        // and when the stream is destroyed. A fresh UTF-8 stream over a
+        // SourceFile publishes the file's line index right away instead.
+        void set_location_table(LocationTable& table,
+                                SourceLocation::FileId file);
+
+        // Ill-formed sequences decoded so far, ordered by offset. The stream
+        // decodes ahead of get() by up to the largest peek() offset used.
+        std::vector<InvalidSequence> const& get_invalid_sequences() const;
+
+        // Lexer state tag recorded in subsequent snapshots.
+        void set_state(int state);
+
+        int get_state() const;
+
+        // Records a snapshot at the start of every num_lines-th line;
+        // 0 (the default) records only the one at the start of input.
+        void set_snapshot_interval(int num_lines);
+
+        std::vector<Snapshot> const& get_snapshots() const;
+
+        // Replaces the stream with an edited version of the same input, in
+        // which the old_length bytes at edit_offset were replaced by
+        // new_length bytes, and restores the last snapshot before
+        // edit_offset. Snapshots past the edit are kept with their offsets
+        // shifted; their lines and positions are corrected once get()
+        // reaches the first of them. The new stream must be seekable.
+        Snapshot resume(std::unique_ptr<std::istream>&& stream,
+                        std::uint64_t edit_offset, std::uint64_t old_length,
+                        std::uint64_t new_length);
+
+        Snapshot resume(std::shared_ptr<SourceFile const> source,
+                        std::uint64_t edit_offset, std::uint64_t old_length,
+                        std::uint64_t new_length);
+
+        // Whether the last line start get() reached after resume() was a
+        // snapshot kept past the edit, with the same state as recorded
+        // there. From then on the input and the lexer state are the same as
+        // before the edit, so relexing can stop.
+        bool is_synchronized() const;
+
     private:
         void populate_buffer(std::uint8_t num);
 
+        void push_code_point(int code_point);
+
+        bool transcode_run();
+
+        int decode();
+
+        void refill();
+
+        std::size_t bytes_needed() const;
+
+        void detect_encoding();
+
+        char const* find_valid_end() const;
+
+        bool is_invalid_sequence(char const* begin, char const* end) const;
+
+        void take_snapshot();
+
+        bool is_catching_up() const;
+
+        void publish_lines(bool truncate);
+
+        Snapshot rewind(std::uint64_t edit_offset, std::uint64_t old_length,
+                        std::uint64_t new_length);
+
+        void add_invalid_sequence(InvalidSequence const& sequence);
+
+        void drop_kept_invalid_sequences(std::uint64_t offset);
+
+        void open(std::shared_ptr<SourceFile const>&& source,
+                  std::uint64_t offset);
+
+        std::uint64_t decoded_offset() const;
+
     private:
+        static constexpr std::size_t CHUNK_SIZE = 16 * 1024;
+        static constexpr std::size_t LINE_BATCH_SIZE = 1024;
+
         std::unique_ptr<std::istream> stream_;
+        std::shared_ptr<SourceFile const> source_;
+        Encoding initial_encoding_;
+        Encoding encoding_;
         CodePointBuffer buffer_;
+        // [begin_, end_) is either the last chunk read from stream_ or the
+        // whole of source_, and pos_ is the next byte to decode. For UTF-8
+        // input [pos_, valid_end_) is known to be well-formed and is decoded
+        // without any checks; otherwise valid_end_ stays at pos_.
+        std::vector<char> chunk_;
+        char const* begin_;
+        char const* pos_;
+        char const* valid_end_;
+        char const* end_;
+        bool stream_end_;
+        std::uint64_t chunk_offset_;
+        std::uint64_t offset_;
+        std::uint64_t position_;
         int line_;
         int column_;
         bool ignore_line_feed_;
+        int state_;
+        int snapshot_interval_;
+        std::vector<Snapshot> snapshots_;
+        // snapshots_[next_kept_, end) were kept past the last edit and have
+        // not been reached yet
+        std::size_t next_kept_;
+        bool kept_reached_;
+        bool synchronized_;
+        std::vector<InvalidSequence> invalid_sequences_;
+        // invalid_sequences_[next_kept_invalid_, end) were kept past the
+        // last edit and have not been decoded again yet
+        std::size_t next_kept_invalid_;
+        LocationTable* location_table_;
+        SourceLocation::FileId file_;
+        std::uint32_t location_start_;
+        std::uint64_t location_size_;
+        // starts of the lines from first_pending_line_ on that have not
+        // been published to location_table_ yet
+        std::vector<std::uint64_t> pending_lines_;
+        int first_pending_line_;
     };
 
 } // close klex namespace
@@ -0,0 +1,39 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LATIN1DECODER_H_INCLUDED_W0B5NHEA
+#define LATIN1DECODER_H_INCLUDED_W0B5NHEA
+
+#include <cstdio>
+
+namespace klex
+{
+
+    class Latin1Decoder
+    {
+    public:
+        int decode(char const*& it, char const* end) const
+        {
+            if (it == end)
+            {
+                return EOF;
+            }
+            return static_cast<unsigned char>(*it++);
+        }
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,178 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LocationTable.h"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace klex
+{
+
+    LocationTable::LocationTable()
+    : mutex_{}
+    , files_{}
+    , next_start_{1}
+    {
+    }
+
+    SourceLocation::FileId LocationTable::add_file(std::string name,
+                                                   std::uint64_t size)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        std::uint64_t const end = next_start_ + size + 1;
+        if (size > UINT32_MAX || end > UINT64_C(1) << 32)
+        {
+            throw std::length_error("LocationTable: out of locations");
+        }
+        files_.push_back(File{std::move(name),
+                              static_cast<std::uint32_t>(next_start_), size,
+                              {0}});
+        next_start_ = end;
+        return static_cast<SourceLocation::FileId>(files_.size());
+    }
+
+    SourceLocation::FileId LocationTable::add_file(SourceFile const& source)
+    {
+        SourceLocation::FileId const file =
+            add_file(source.get_path(), source.size());
+        replace_lines(file, 2, 2, source.get_line_starts(), 0);
+        return file;
+    }
+
+    std::string const&
+    LocationTable::get_file_name(SourceLocation::FileId file) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return get(file).name;
+    }
+
+    std::uint64_t
+    LocationTable::get_file_size(SourceLocation::FileId file) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return get(file).size;
+    }
+
+    SourceLocation LocationTable::get_location(SourceLocation::FileId file,
+                                               std::uint64_t position) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        File const& entry = get(file);
+        if (position > entry.size)
+        {
+            throw std::out_of_range("LocationTable: position past end of file");
+        }
+        return SourceLocation{static_cast<std::uint32_t>(entry.start +
+                                                         position)};
+    }
+
+    SourceLocation::FileId
+    LocationTable::get_file(SourceLocation location) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return static_cast<SourceLocation::FileId>(
+            find_file(location) - files_.begin()) + 1;
+    }
+
+    int LocationTable::get_line(SourceLocation location) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        File const& file = *find_file(location);
+        auto it = find_line(file, location.get_raw() - file.start);
+        return static_cast<int>(it - file.line_starts.begin()) + 1;
+    }
+
+    int LocationTable::get_column(SourceLocation location) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        File const& file = *find_file(location);
+        std::uint64_t const position = location.get_raw() - file.start;
+        auto it = find_line(file, position);
+        return static_cast<int>(position - *it) + 1;
+    }
+
+    void LocationTable::replace_lines(SourceLocation::FileId file,
+                                      int first_line, int end_line,
+                                      std::vector<std::uint64_t> const& starts,
+                                      std::int64_t position_delta)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        assert(file != 0 && file <= files_.size());
+        std::vector<std::uint64_t>& line_starts = files_[file - 1].line_starts;
+        assert(first_line >= 2 && first_line <= end_line);
+        std::size_t const first = first_line - 1;
+        std::size_t const last =
+            std::min<std::size_t>(end_line - 1, line_starts.size());
+        assert(first <= last);
+        for (std::size_t i = last; i < line_starts.size(); ++i)
+        {
+            line_starts[i] += position_delta;
+        }
+        // overwrite in place so that republishing unchanged lines does not
+        // move the ones after them
+        std::size_t const common = std::min(last - first, starts.size());
+        std::copy(starts.begin(), starts.begin() + common,
+                  line_starts.begin() + first);
+        if (common < starts.size())
+        {
+            line_starts.insert(line_starts.begin() + last,
+                               starts.begin() + common, starts.end());
+        }
+        else
+        {
+            line_starts.erase(line_starts.begin() + first + common,
+                              line_starts.begin() + last);
+        }
+    }
+
+    LocationTable::File const&
+    LocationTable::get(SourceLocation::FileId file) const
+    {
+        if (file == 0 || file > files_.size())
+        {
+            throw std::out_of_range("LocationTable: unknown file id");
+        }
+        return files_[file - 1];
+    }
+
+    std::deque<LocationTable::File>::const_iterator
+    LocationTable::find_file(SourceLocation location) const
+    {
+        auto it = std::upper_bound(
+            files_.begin(), files_.end(), location.get_raw(),
+            [](std::uint32_t raw, File const& file)
+            {
+                return raw < file.start;
+            });
+        if (it == files_.begin() ||
+            location.get_raw() - (it - 1)->start > (it - 1)->size)
+        {
+            throw std::out_of_range("LocationTable: unknown location");
+        }
+        return it - 1;
+    }
+
+    std::vector<std::uint64_t>::const_iterator
+    LocationTable::find_line(File const& file, std::uint64_t position) const
+    {
+        // the first line always starts at 0 so this never returns begin()
+        auto it = std::upper_bound(file.line_starts.begin(),
+                                   file.line_starts.end(), position);
+        return it - 1;
+    }
+
+} // close klex namespace
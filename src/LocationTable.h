@@ -0,0 +1,99 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LOCATIONTABLE_H_INCLUDED_H4NW9CJE
+#define LOCATIONTABLE_H_INCLUDED_H4NW9CJE
+
+#include "SourceFile.h"
+#include "SourceLocation.h"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace klex
+{
+
+    // Hands out SourceLocations and maps them back to file names, lines
+    // and columns. Every file gets a contiguous range of the 32-bit
+    // location space, so a location is found by a binary search over the
+    // file ranges. Line starts are filled in by the InputStreams attached
+    // to the table, in batches, or taken from the index of a SourceFile.
+    // All member functions are thread-safe.
+    class LocationTable
+    {
+    public:
+        LocationTable();
+
+        // Reserves locations for up to size code points and the end of the
+        // file; the size of the file in bytes is always enough. Ids start
+        // at 1, and a default constructed SourceLocation is invalid.
+        SourceLocation::FileId add_file(std::string name, std::uint64_t size);
+
+        // Adds source under its path, with its size in bytes and the line
+        // starts it indexed for UTF-8 decoding.
+        SourceLocation::FileId add_file(SourceFile const& source);
+
+        std::string const& get_file_name(SourceLocation::FileId file) const;
+
+        std::uint64_t get_file_size(SourceLocation::FileId file) const;
+
+        SourceLocation get_location(SourceLocation::FileId file,
+                                    std::uint64_t position) const;
+
+        SourceLocation::FileId get_file(SourceLocation location) const;
+
+        int get_line(SourceLocation location) const;
+
+        int get_column(SourceLocation location) const;
+
+        // Replaces the starts of lines [first_line, end_line) of file by the
+        // code point positions in starts and shifts the starts of the lines
+        // after them by position_delta. end_line may lie past the last
+        // line. The first line always starts at 0, so first_line is at
+        // least 2.
+        void replace_lines(SourceLocation::FileId file, int first_line,
+                           int end_line,
+                           std::vector<std::uint64_t> const& starts,
+                           std::int64_t position_delta);
+
+    private:
+        struct File
+        {
+            std::string name;
+            std::uint32_t start;
+            std::uint64_t size;
+            std::vector<std::uint64_t> line_starts;
+        };
+
+        File const& get(SourceLocation::FileId file) const;
+
+        std::deque<File>::const_iterator
+        find_file(SourceLocation location) const;
+
+        std::vector<std::uint64_t>::const_iterator
+        find_line(File const& file, std::uint64_t position) const;
+
+    private:
+        mutable std::mutex mutex_;
+        // deque keeps references to files stable while new ones are added
+        std::deque<File> files_;
+        std::uint64_t next_start_;
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,305 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "NfcNormalizer.h"
+#include "NfcTables.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace klex
+{
+
+    namespace
+    {
+
+        // nothing below these code points decomposes, or has a non-zero
+        // combining class or a quick check value other than yes
+        int const FIRST_DECOMPOSABLE = 0xC0;
+        int const FIRST_INTERESTING = 0x300;
+
+        int const S_BASE = 0xAC00;
+        int const L_BASE = 0x1100;
+        int const V_BASE = 0x1161;
+        int const T_BASE = 0x11A7;
+        int const L_COUNT = 19;
+        int const V_COUNT = 21;
+        int const T_COUNT = 28;
+        int const N_COUNT = V_COUNT * T_COUNT;
+        int const S_COUNT = L_COUNT * N_COUNT;
+
+        int find_range(nfc_tables::Range const* ranges, std::size_t size,
+                       int code_point)
+        {
+            nfc_tables::Range const* end = ranges + size;
+            nfc_tables::Range const* it = std::upper_bound(
+                ranges, end, code_point,
+                [](int cp, nfc_tables::Range const& range)
+                {
+                    return cp < range.first;
+                });
+            if (it == ranges || (it - 1)->last < code_point)
+            {
+                return 0;
+            }
+            return (it - 1)->value;
+        }
+
+        int combining_class(int code_point)
+        {
+            if (code_point < FIRST_INTERESTING)
+            {
+                return 0;
+            }
+            return find_range(nfc_tables::combining_classes,
+                              nfc_tables::combining_classes_size, code_point);
+        }
+
+        NfcNormalizer::QuickCheck quick_check_value(int code_point)
+        {
+            if (code_point < FIRST_INTERESTING)
+            {
+                return NfcNormalizer::QuickCheck::yes;
+            }
+            switch (find_range(nfc_tables::quick_check,
+                               nfc_tables::quick_check_size, code_point))
+            {
+            case 1:
+                return NfcNormalizer::QuickCheck::no;
+            case 2:
+                return NfcNormalizer::QuickCheck::maybe;
+            default:
+                return NfcNormalizer::QuickCheck::yes;
+            }
+        }
+
+        // Returns 0 if the pair does not compose.
+        int compose_pair(int first, int second)
+        {
+            if (first >= L_BASE && first < L_BASE + L_COUNT &&
+                second >= V_BASE && second < V_BASE + V_COUNT)
+            {
+                return S_BASE +
+                       ((first - L_BASE) * V_COUNT + (second - V_BASE)) *
+                           T_COUNT;
+            }
+            if (first >= S_BASE && first < S_BASE + S_COUNT &&
+                (first - S_BASE) % T_COUNT == 0 && second > T_BASE &&
+                second < T_BASE + T_COUNT)
+            {
+                return first + (second - T_BASE);
+            }
+            nfc_tables::Composition const* begin = nfc_tables::compositions;
+            nfc_tables::Composition const* end =
+                begin + nfc_tables::compositions_size;
+            nfc_tables::Composition const* it = std::lower_bound(
+                begin, end, nfc_tables::Composition{first, second, 0},
+                [](nfc_tables::Composition const& lhs,
+                   nfc_tables::Composition const& rhs)
+                {
+                    return lhs.first < rhs.first ||
+                           (lhs.first == rhs.first && lhs.second < rhs.second);
+                });
+            if (it == end || it->first != first || it->second != second)
+            {
+                return 0;
+            }
+            return it->composite;
+        }
+
+    } // close unnamed namespace
+
+    NfcNormalizer::QuickCheck
+    NfcNormalizer::quick_check(int const* begin, int const* end) const
+    {
+        QuickCheck result = QuickCheck::yes;
+        int last_class = 0;
+        for (int const* it = begin; it != end; ++it)
+        {
+            if (*it < FIRST_INTERESTING)
+            {
+                last_class = 0;
+                continue;
+            }
+            int cls = combining_class(*it);
+            if (cls != 0 && last_class > cls)
+            {
+                return QuickCheck::no;
+            }
+            QuickCheck value = quick_check_value(*it);
+            if (value == QuickCheck::no)
+            {
+                return QuickCheck::no;
+            }
+            if (value == QuickCheck::maybe)
+            {
+                result = QuickCheck::maybe;
+            }
+            last_class = cls;
+        }
+        return result;
+    }
+
+    bool NfcNormalizer::normalize(int const* begin, int const* end,
+                                  std::vector<int>& out) const
+    {
+        int const* unstable = find_unstable(begin, end);
+        if (unstable == end)
+        {
+            return true;
+        }
+        // everything before the last starter preceding the first offending
+        // code point is unaffected by normalization
+        int const* start = unstable;
+        while (start != begin)
+        {
+            --start;
+            if (combining_class(*start) == 0)
+            {
+                break;
+            }
+        }
+
+        std::vector<int> tail;
+        for (int const* it = start; it != end; ++it)
+        {
+            decompose(*it, tail);
+        }
+        reorder(tail);
+        compose(tail);
+        if (static_cast<std::size_t>(end - start) == tail.size() &&
+            std::equal(tail.begin(), tail.end(), start))
+        {
+            return true;
+        }
+        out.assign(begin, start);
+        out.insert(out.end(), tail.begin(), tail.end());
+        return false;
+    }
+
+    int const* NfcNormalizer::find_unstable(int const* begin,
+                                            int const* end) const
+    {
+        int last_class = 0;
+        for (int const* it = begin; it != end; ++it)
+        {
+            if (*it < FIRST_INTERESTING)
+            {
+                last_class = 0;
+                continue;
+            }
+            int cls = combining_class(*it);
+            if ((cls != 0 && last_class > cls) ||
+                quick_check_value(*it) != QuickCheck::yes)
+            {
+                return it;
+            }
+            last_class = cls;
+        }
+        return end;
+    }
+
+    void NfcNormalizer::decompose(int code_point, std::vector<int>& out) const
+    {
+        if (code_point < FIRST_DECOMPOSABLE)
+        {
+            out.push_back(code_point);
+            return;
+        }
+        int s_index = code_point - S_BASE;
+        if (s_index >= 0 && s_index < S_COUNT)
+        {
+            out.push_back(L_BASE + s_index / N_COUNT);
+            out.push_back(V_BASE + (s_index % N_COUNT) / T_COUNT);
+            if (s_index % T_COUNT != 0)
+            {
+                out.push_back(T_BASE + s_index % T_COUNT);
+            }
+            return;
+        }
+        nfc_tables::Decomposition const* begin = nfc_tables::decompositions;
+        nfc_tables::Decomposition const* end =
+            begin + nfc_tables::decompositions_size;
+        nfc_tables::Decomposition const* it = std::lower_bound(
+            begin, end, code_point,
+            [](nfc_tables::Decomposition const& decomposition, int cp)
+            {
+                return decomposition.code_point < cp;
+            });
+        if (it == end || it->code_point != code_point)
+        {
+            out.push_back(code_point);
+            return;
+        }
+        int const* data = nfc_tables::decomposition_data + it->offset;
+        out.insert(out.end(), data, data + it->length);
+    }
+
+    void NfcNormalizer::reorder(std::vector<int>& code_points) const
+    {
+        // canonical ordering: a stable sort of each run of non-starters by
+        // combining class; the runs are short so insertion sort is enough
+        for (std::size_t i = 1; i < code_points.size(); ++i)
+        {
+            int cls = combining_class(code_points[i]);
+            if (cls == 0)
+            {
+                continue;
+            }
+            std::size_t j = i;
+            while (j > 0 && combining_class(code_points[j - 1]) > cls)
+            {
+                std::swap(code_points[j - 1], code_points[j]);
+                --j;
+            }
+        }
+    }
+
+    void NfcNormalizer::compose(std::vector<int>& code_points) const
+    {
+        std::size_t size = 0;
+        std::size_t starter = 0;
+        bool have_starter = false;
+        // combining class of the last code point kept after the starter,
+        // -1 if there is none
+        int last_class = -1;
+        for (std::size_t i = 0; i < code_points.size(); ++i)
+        {
+            int code_point = code_points[i];
+            int cls = combining_class(code_point);
+            if (have_starter && (last_class == -1 || last_class < cls))
+            {
+                int composite = compose_pair(code_points[starter], code_point);
+                if (composite != 0)
+                {
+                    code_points[starter] = composite;
+                    continue;
+                }
+            }
+            if (cls == 0)
+            {
+                starter = size;
+                have_starter = true;
+                last_class = -1;
+            }
+            else
+            {
+                last_class = cls;
+            }
+            code_points[size++] = code_point;
+        }
+        code_points.resize(size);
+    }
+
+} // close klex namespace
@@ -0,0 +1,59 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NFCNORMALIZER_H_INCLUDED_LC2ZT9QU
+#define NFCNORMALIZER_H_INCLUDED_LC2ZT9QU
+
+#include <vector>
+
+namespace klex
+{
+
+    // Unicode Normalization Form C for sequences of code points, such as
+    // identifiers read from an InputStream.
+    class NfcNormalizer
+    {
+    public:
+        enum class QuickCheck
+        {
+            yes,
+            no,
+            maybe
+        };
+
+        // Answers whether [begin, end) is in NFC without normalizing it;
+        // maybe means normalize() has to decide.
+        QuickCheck quick_check(int const* begin, int const* end) const;
+
+        // Returns true if [begin, end) is already in NFC; out is left
+        // untouched then. Otherwise stores the NFC form in out and returns
+        // false. Only the part starting at the last starter before the
+        // first code point that fails the quick check is normalized.
+        bool normalize(int const* begin, int const* end,
+                       std::vector<int>& out) const;
+
+    private:
+        int const* find_unstable(int const* begin, int const* end) const;
+
+        void decompose(int code_point, std::vector<int>& out) const;
+
+        void reorder(std::vector<int>& code_points) const;
+
+        void compose(std::vector<int>& code_points) const;
+    };
+
+} // close klex namespace
+
+#endif // include guard
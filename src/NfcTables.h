@@ -0,0 +1,72 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NFCTABLES_H_INCLUDED_B6WE1YJS
+#define NFCTABLES_H_INCLUDED_B6WE1YJS
+
+#include <cstddef>
+
+namespace klex
+{
+
+    // Unicode data used by NfcNormalizer, see tools/gen_nfc_tables.py.
+    // All tables are sorted by code point.
+    namespace nfc_tables
+    {
+
+        struct Range
+        {
+            int first;
+            int last;
+            int value;
+        };
+
+        struct Decomposition
+        {
+            int code_point;
+            // full canonical decomposition in decomposition_data
+            int offset;
+            int length;
+        };
+
+        struct Composition
+        {
+            int first;
+            int second;
+            int composite;
+        };
+
+        // non-zero canonical combining classes
+        extern Range const combining_classes[];
+        extern std::size_t const combining_classes_size;
+
+        // NFC_Quick_Check values: 1 for No, 2 for Maybe
+        extern Range const quick_check[];
+        extern std::size_t const quick_check_size;
+
+        // excludes Hangul syllables, which are decomposed algorithmically
+        extern Decomposition const decompositions[];
+        extern std::size_t const decompositions_size;
+        extern int const decomposition_data[];
+
+        // primary composites, sorted by first and second
+        extern Composition const compositions[];
+        extern std::size_t const compositions_size;
+
+    } // close nfc_tables namespace
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,263 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "PipelinedInputStream.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <utility>
+
+namespace klex
+{
+
+    PipelinedInputStream::PipelinedInputStream(
+        std::unique_ptr<InputStream>&& input)
+    : input_{std::move(input)}
+    , queue_{new SpscQueue<Batch, QUEUE_SIZE>}
+    , stop_{false}
+    , mutex_{}
+    , producer_sleeping_{false}
+    , consumer_sleeping_{false}
+    , changed_{}
+    , error_{}
+    , invalid_published_{input_->get_invalid_sequences().size()}
+    , buffer_{}
+    , batch_{nullptr}
+    , batch_pos_{0}
+    , input_end_{false}
+    , decoded_offset_{input_->get_offset()}
+    , offset_{decoded_offset_}
+    , position_{input_->get_position()}
+    , line_{input_->get_line()}
+    , column_{input_->get_column()}
+    , invalid_sequences_(input_->get_invalid_sequences())
+    , producer_{&PipelinedInputStream::produce, this}
+    {
+    }
+
+    PipelinedInputStream::~PipelinedInputStream()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            changed_.notify_all();
+        }
+        producer_.join();
+    }
+
+    int PipelinedInputStream::get()
+    {
+        populate_buffer(0);
+        int code_point = buffer_.front();
+        offset_ = buffer_.front_offset();
+        buffer_.pop_front();
+        if (code_point == '\n')
+        {
+            ++position_;
+            ++line_;
+            column_ = 1;
+        }
+        else if (code_point != EOF)
+        {
+            ++position_;
+            ++column_;
+        }
+        return code_point;
+    }
+
+    int PipelinedInputStream::peek(std::uint8_t offset)
+    {
+        populate_buffer(offset);
+        return buffer_[offset];
+    }
+
+    int PipelinedInputStream::get_line() const
+    {
+        return line_;
+    }
+
+    int PipelinedInputStream::get_column() const
+    {
+        return column_;
+    }
+
+    std::uint64_t PipelinedInputStream::get_offset() const
+    {
+        return offset_;
+    }
+
+    SourceLocation PipelinedInputStream::get_location() const
+    {
+        // only reads what the producer never changes
+        return input_->get_location(position_);
+    }
+
+    std::vector<InputStream::InvalidSequence> const&
+    PipelinedInputStream::get_invalid_sequences() const
+    {
+        return invalid_sequences_;
+    }
+
+    void PipelinedInputStream::produce()
+    {
+        try
+        {
+            bool done = false;
+            while (!done)
+            {
+                Batch* batch = reserve_batch();
+                if (!batch)
+                {
+                    return;
+                }
+                std::size_t size = 0;
+                while (size < BATCH_SIZE && !done)
+                {
+                    int code_point = input_->get();
+                    batch->code_points[size] = code_point;
+                    batch->end_offsets[size] = input_->get_offset();
+                    ++size;
+                    done = code_point == EOF;
+                }
+                batch->size = size;
+                auto const& invalid = input_->get_invalid_sequences();
+                batch->invalid_sequences.assign(
+                    invalid.begin() +
+                        std::min(invalid_published_, invalid.size()),
+                    invalid.end());
+                invalid_published_ = invalid.size();
+                queue_->commit();
+                wake(true);
+            }
+        }
+        catch (...)
+        {
+            error_ = std::current_exception();
+            if (Batch* batch = reserve_batch())
+            {
+                batch->size = 0;
+                queue_->commit();
+                wake(true);
+            }
+        }
+    }
+
+    PipelinedInputStream::Batch* PipelinedInputStream::reserve_batch()
+    {
+        Batch* batch;
+        for (int spin = 0; !(batch = queue_->try_reserve()); ++spin)
+        {
+            if (stop_.load(std::memory_order_relaxed))
+            {
+                return nullptr;
+            }
+            if (spin < SPIN_COUNT)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                sleep(true);
+            }
+        }
+        return batch;
+    }
+
+    void PipelinedInputStream::sleep(bool producer)
+    {
+        // the other side takes mutex_ after every commit() or pop(), so it
+        // either sees this side's flag or the check below sees its update.
+        // Each side has a flag of its own: with a shared one, a side waking
+        // up could clear it while the other had just gone to sleep, which
+        // would then never be woken.
+        std::unique_lock<std::mutex> lock{mutex_};
+        bool& sleeping = producer ? producer_sleeping_ : consumer_sleeping_;
+        sleeping = true;
+        changed_.wait(lock, [this, producer]
+        {
+            return producer ? queue_->try_reserve() != nullptr ||
+                                  stop_.load(std::memory_order_relaxed)
+                            : queue_->try_front() != nullptr;
+        });
+        sleeping = false;
+    }
+
+    void PipelinedInputStream::wake(bool producer)
+    {
+        // wakes the other side; once per batch, so the lock is cheap next
+        // to the work per batch
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (producer ? consumer_sleeping_ : producer_sleeping_)
+        {
+            // both sides wait on changed_, so notify_one() could pick the
+            // wrong one
+            changed_.notify_all();
+        }
+    }
+
+    void PipelinedInputStream::populate_buffer(std::uint8_t num)
+    {
+        assert(num < buffer_.max_size());
+        while (num >= buffer_.size())
+        {
+            int code_point = next_code_point();
+            buffer_.push_back(code_point, decoded_offset_);
+        }
+    }
+
+    int PipelinedInputStream::next_code_point()
+    {
+        if (input_end_)
+        {
+            return EOF;
+        }
+        if (!batch_)
+        {
+            Batch const* batch;
+            for (int spin = 0; !(batch = queue_->try_front()); ++spin)
+            {
+                if (spin < SPIN_COUNT)
+                {
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    sleep(false);
+                }
+            }
+            if (batch->size == 0)
+            {
+                std::rethrow_exception(error_);
+            }
+            batch_ = batch;
+            batch_pos_ = 0;
+            invalid_sequences_.insert(invalid_sequences_.end(),
+                                      batch->invalid_sequences.begin(),
+                                      batch->invalid_sequences.end());
+        }
+        int code_point = batch_->code_points[batch_pos_];
+        decoded_offset_ = batch_->end_offsets[batch_pos_];
+        ++batch_pos_;
+        if (batch_pos_ == batch_->size)
+        {
+            batch_ = nullptr;
+            queue_->pop();
+            wake(false);
+        }
+        input_end_ = code_point == EOF;
+        return code_point;
+    }
+
+} // close klex namespace
@@ -0,0 +1,126 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PIPELINEDINPUTSTREAM_H_INCLUDED_VN5C0PLK
+#define PIPELINEDINPUTSTREAM_H_INCLUDED_VN5C0PLK
+
+#include "CodePointBuffer.h"
+#include "InputStream.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace klex
+{
+
+    // Same interface as InputStream, but decoding happens on a separate
+    // producer thread which hands code points over in batches. Either side
+    // spins briefly when the queue is full or empty and then blocks until
+    // the other one catches up. Exceptions thrown while decoding are
+    // rethrown by get() and peek(). The location table, if any, must be set
+    // on the input before it is handed over.
+    class PipelinedInputStream
+    {
+    public:
+        explicit PipelinedInputStream(std::unique_ptr<InputStream>&& input);
+
+        // Stops the producer thread. It cannot be interrupted while it is
+        // blocked reading the underlying stream.
+        ~PipelinedInputStream();
+
+        PipelinedInputStream(PipelinedInputStream const&) = delete;
+        PipelinedInputStream& operator=(PipelinedInputStream const&) = delete;
+
+        int get();
+
+        int peek(std::uint8_t offset);
+
+        int get_line() const;
+
+        int get_column() const;
+
+        std::uint64_t get_offset() const;
+
+        SourceLocation get_location() const;
+
+        // Ill-formed sequences in the batches taken over from the producer
+        // so far, ordered by offset.
+        std::vector<InputStream::InvalidSequence> const&
+        get_invalid_sequences() const;
+
+    private:
+        static constexpr std::size_t BATCH_SIZE = 1024;
+        static constexpr std::size_t QUEUE_SIZE = 16;
+        static constexpr int SPIN_COUNT = 64;
+
+        struct Batch
+        {
+            // 0 if the producer failed; the error is in error_
+            std::size_t size;
+            int code_points[BATCH_SIZE];
+            // byte offset right after each code point
+            std::uint64_t end_offsets[BATCH_SIZE];
+            // found since the previous batch
+            std::vector<InputStream::InvalidSequence> invalid_sequences;
+        };
+
+        void produce();
+
+        Batch* reserve_batch();
+
+        void sleep(bool producer);
+
+        void wake(bool producer);
+
+        void populate_buffer(std::uint8_t num);
+
+        int next_code_point();
+
+    private:
+        std::unique_ptr<InputStream> input_;
+        std::unique_ptr<SpscQueue<Batch, QUEUE_SIZE>> queue_;
+        std::atomic<bool> stop_;
+        std::mutex mutex_;
+        // whether each side is blocked on changed_; guarded by mutex_
+        bool producer_sleeping_;
+        bool consumer_sleeping_;
+        std::condition_variable changed_;
+        std::exception_ptr error_;
+        // used by the producer only
+        std::size_t invalid_published_;
+        CodePointBuffer buffer_;
+        Batch const* batch_;
+        std::size_t batch_pos_;
+        bool input_end_;
+        // end offset of the code point last taken from a batch
+        std::uint64_t decoded_offset_;
+        std::uint64_t offset_;
+        std::uint64_t position_;
+        int line_;
+        int column_;
+        std::vector<InputStream::InvalidSequence> invalid_sequences_;
+        std::thread producer_;
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,168 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SourceCache.h"
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+namespace klex
+{
+
+    namespace
+    {
+
+        std::vector<char> read_file(std::string const& path)
+        {
+            std::ifstream is(path, std::ios::binary);
+            if (!is.seekg(0, std::ios::end))
+            {
+                throw std::runtime_error("SourceCache: cannot open " + path);
+            }
+            std::vector<char> bytes(static_cast<std::size_t>(is.tellg()));
+            is.seekg(0, std::ios::beg);
+            if (!is.read(bytes.data(), bytes.size()))
+            {
+                throw std::runtime_error("SourceCache: cannot read " + path);
+            }
+            return bytes;
+        }
+
+        // Modification time in nanoseconds since the epoch. Whole seconds
+        // would miss a rewrite of the same size right after the file was
+        // read, so the finest resolution the platform offers is used.
+        std::int64_t get_mtime(struct stat const& status)
+        {
+#if defined(__APPLE__)
+            return status.st_mtimespec.tv_sec * INT64_C(1000000000) +
+                   status.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+            return status.st_mtime * INT64_C(1000000000);
+#else
+            // POSIX.1-2008
+            return status.st_mtim.tv_sec * INT64_C(1000000000) +
+                   status.st_mtim.tv_nsec;
+#endif
+        }
+
+    } // close unnamed namespace
+
+    SourceCache::SourceCache(std::size_t memory_budget)
+    : memory_budget_{memory_budget}
+    , memory_usage_{0}
+    , loads_{0}
+    {
+    }
+
+    SourceCache& SourceCache::instance()
+    {
+        static SourceCache cache{256 * 1024 * 1024};
+        return cache;
+    }
+
+    std::shared_ptr<SourceFile const> SourceCache::get(std::string const& path)
+    {
+        struct stat status;
+        if (::stat(path.c_str(), &status) != 0)
+        {
+            throw std::runtime_error("SourceCache: cannot open " + path);
+        }
+        std::int64_t const mtime = get_mtime(status);
+        std::int64_t const size = status.st_size;
+
+        std::unique_lock<std::mutex> lock{mutex_};
+        auto it = entries_.find(path);
+        if (it != entries_.end() && it->second.mtime == mtime &&
+            it->second.size == size)
+        {
+            lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+            // waits outside the lock if the file is still being read
+            auto file = it->second.file;
+            lock.unlock();
+            return file.get();
+        }
+        if (it != entries_.end())
+        {
+            erase(it);
+        }
+        std::promise<std::shared_ptr<SourceFile const>> promise;
+        std::uint64_t const load = ++loads_;
+        lru_.push_front(path);
+        entries_.emplace(path, Entry{promise.get_future().share(), mtime, size,
+                                     load, 0, lru_.begin()});
+        lock.unlock();
+
+        // read without holding the lock
+        std::shared_ptr<SourceFile const> file;
+        try
+        {
+            file = std::make_shared<SourceFile>(path, read_file(path));
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+            lock.lock();
+            it = entries_.find(path);
+            if (it != entries_.end() && it->second.load == load)
+            {
+                erase(it);
+            }
+            throw;
+        }
+        promise.set_value(file);
+
+        lock.lock();
+        it = entries_.find(path);
+        if (it != entries_.end() && it->second.load == load)
+        {
+            it->second.memory_usage = file->get_memory_usage();
+            memory_usage_ += it->second.memory_usage;
+            evict();
+        }
+        return file;
+    }
+
+    void SourceCache::set_memory_budget(std::size_t memory_budget)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        memory_budget_ = memory_budget;
+        evict();
+    }
+
+    std::size_t SourceCache::get_memory_usage() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return memory_usage_;
+    }
+
+    void
+    SourceCache::erase(std::unordered_map<std::string, Entry>::iterator it)
+    {
+        memory_usage_ -= it->second.memory_usage;
+        lru_.erase(it->second.lru_position);
+        entries_.erase(it);
+    }
+
+    void SourceCache::evict()
+    {
+        while (memory_usage_ > memory_budget_)
+        {
+            erase(entries_.find(lru_.back()));
+        }
+    }
+
+} // close klex namespace
@@ -0,0 +1,84 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SOURCECACHE_H_INCLUDED_E2YB7UFS
+#define SOURCECACHE_H_INCLUDED_E2YB7UFS
+
+#include "SourceFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace klex
+{
+
+    // Thread-safe cache of SourceFiles keyed by path and modification time.
+    // A file is read by the first thread that misses it; others asking for
+    // it meanwhile wait for that read. Least recently used files are
+    // evicted once the total memory usage exceeds the budget; evicted files
+    // stay alive for as long as someone still holds them.
+    class SourceCache
+    {
+    public:
+        explicit SourceCache(std::size_t memory_budget);
+
+        // Process-wide cache with a 256 MiB budget.
+        static SourceCache& instance();
+
+        // Returns the cached file, or reads it if it is not cached or has
+        // been modified since. Throws std::runtime_error if the file cannot
+        // be read.
+        std::shared_ptr<SourceFile const> get(std::string const& path);
+
+        void set_memory_budget(std::size_t memory_budget);
+
+        std::size_t get_memory_usage() const;
+
+    private:
+        struct Entry
+        {
+            std::shared_future<std::shared_ptr<SourceFile const>> file;
+            // nanoseconds since the epoch
+            std::int64_t mtime;
+            std::int64_t size;
+            // tells the load that created the entry from later ones
+            std::uint64_t load;
+            // 0 until the file has been read
+            std::size_t memory_usage;
+            std::list<std::string>::iterator lru_position;
+        };
+
+        void erase(std::unordered_map<std::string, Entry>::iterator it);
+
+        void evict();
+
+    private:
+        mutable std::mutex mutex_;
+        std::size_t memory_budget_;
+        std::size_t memory_usage_;
+        std::uint64_t loads_;
+        // most recently used first
+        std::list<std::string> lru_;
+        std::unordered_map<std::string, Entry> entries_;
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,88 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SourceFile.h"
+#include "Utf8Decoder.h"
+#include <utility>
+
+namespace klex
+{
+
+    SourceFile::SourceFile(std::string path, std::vector<char>&& bytes)
+    : path_{std::move(path)}
+    , bytes_{std::move(bytes)}
+    , valid_size_{0}
+    , line_starts_{}
+    {
+        char const* it = bytes_.data();
+        char const* const end = it + bytes_.size();
+        char const* const valid_end = Utf8Decoder::validate(it, end);
+        valid_size_ = valid_end - it;
+
+        Utf8Decoder decoder;
+        std::uint64_t position = 0;
+        bool after_carriage_return = false;
+        while (it != end)
+        {
+            int const code_point = it < valid_end
+                                       ? decoder.decode_unchecked(it)
+                                       : decoder.decode(it, end);
+            if (code_point == '\n' && after_carriage_return)
+            {
+                // second half of a CRLF
+                after_carriage_return = false;
+                continue;
+            }
+            ++position;
+            after_carriage_return = code_point == '\r';
+            if (code_point == '\n' || after_carriage_return)
+            {
+                line_starts_.push_back(position);
+            }
+        }
+    }
+
+    std::string const& SourceFile::get_path() const
+    {
+        return path_;
+    }
+
+    char const* SourceFile::data() const
+    {
+        return bytes_.data();
+    }
+
+    std::size_t SourceFile::size() const
+    {
+        return bytes_.size();
+    }
+
+    std::size_t SourceFile::get_valid_size() const
+    {
+        return valid_size_;
+    }
+
+    std::vector<std::uint64_t> const& SourceFile::get_line_starts() const
+    {
+        return line_starts_;
+    }
+
+    std::size_t SourceFile::get_memory_usage() const
+    {
+        return sizeof(*this) + path_.capacity() + bytes_.capacity() +
+               line_starts_.capacity() * sizeof(std::uint64_t);
+    }
+
+} // close klex namespace
@@ -0,0 +1,61 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SOURCEFILE_H_INCLUDED_ZP0V6KRT
+#define SOURCEFILE_H_INCLUDED_ZP0V6KRT
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace klex
+{
+
+    // Immutable contents of a file together with the result of a single
+    // validation pass over it, which also indexes its lines. Can be shared
+    // by any number of InputStreams.
+    class SourceFile
+    {
+    public:
+        SourceFile(std::string path, std::vector<char>&& bytes);
+
+        std::string const& get_path() const;
+
+        char const* data() const;
+
+        std::size_t size() const;
+
+        // Length of the longest well-formed UTF-8 prefix.
+        std::size_t get_valid_size() const;
+
+        // Code point positions at which the lines after the first start,
+        // counted the way an InputStream decoding the file as UTF-8 counts
+        // them: CR, LF and CRLF each end a line and take one position.
+        std::vector<std::uint64_t> const& get_line_starts() const;
+
+        // Approximate number of bytes of memory held by this object.
+        std::size_t get_memory_usage() const;
+
+    private:
+        std::string path_;
+        std::vector<char> bytes_;
+        std::size_t valid_size_;
+        std::vector<std::uint64_t> line_starts_;
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,74 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SOURCELOCATION_H_INCLUDED_Q7LM2XVA
+#define SOURCELOCATION_H_INCLUDED_Q7LM2XVA
+
+#include <cstdint>
+
+namespace klex
+{
+
+    // A code point position in the 32-bit location space of a
+    // LocationTable, in which every file has a range of its own. Use the
+    // table to expand it into a file name, line and column.
+    class SourceLocation
+    {
+    public:
+        // Index of a file in a LocationTable.
+        typedef std::uint32_t FileId;
+
+        SourceLocation()
+        : raw_{0}
+        {
+        }
+
+        explicit SourceLocation(std::uint32_t raw)
+        : raw_{raw}
+        {
+        }
+
+        std::uint32_t get_raw() const
+        {
+            return raw_;
+        }
+
+        bool is_valid() const
+        {
+            return raw_ != 0;
+        }
+
+        bool operator==(SourceLocation const& other) const
+        {
+            return raw_ == other.raw_;
+        }
+
+        bool operator!=(SourceLocation const& other) const
+        {
+            return raw_ != other.raw_;
+        }
+
+        bool operator<(SourceLocation const& other) const
+        {
+            return raw_ < other.raw_;
+        }
+
+    private:
+        std::uint32_t raw_;
+    };
+
+} // close klex namespace
+
+#endif // include guard
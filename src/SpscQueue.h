@@ -0,0 +1,108 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SPSCQUEUE_H_INCLUDED_T8DJ1WQO
+#define SPSCQUEUE_H_INCLUDED_T8DJ1WQO
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+namespace klex
+{
+
+    // Bounded lock-free queue for exactly one producer and one consumer
+    // thread. Elements are written and read in place: the producer fills
+    // the slot returned by try_reserve() and publishes it with commit(),
+    // the consumer reads the slot returned by try_front() and releases it
+    // with pop().
+    template <typename T, std::size_t N>
+    class SpscQueue
+    {
+        static_assert(N != 0 && (N & (N - 1)) == 0,
+                      "capacity must be a power of two");
+
+    public:
+        SpscQueue()
+        : head_{0}
+        , tail_{0}
+        {
+        }
+
+        SpscQueue(SpscQueue const&) = delete;
+        SpscQueue& operator=(SpscQueue const&) = delete;
+
+        std::size_t capacity() const
+        {
+            return N;
+        }
+
+        // Returns nullptr if the queue is full.
+        T* try_reserve()
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == N)
+            {
+                return nullptr;
+            }
+            return &slots_[tail & (N - 1)];
+        }
+
+        void commit()
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            assert(tail - head_.load(std::memory_order_relaxed) < N);
+            tail_.store(tail + 1, std::memory_order_release);
+        }
+
+        // Returns nullptr if the queue is empty.
+        T* try_front()
+        {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            return &slots_[head & (N - 1)];
+        }
+
+        void pop()
+        {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            assert(head != tail_.load(std::memory_order_relaxed));
+            head_.store(head + 1, std::memory_order_release);
+        }
+
+    private:
+        static constexpr std::size_t CACHE_LINE_SIZE = 64;
+        static constexpr std::size_t INDEX_PADDING =
+            CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>);
+
+        // head_ and tail_ live on separate cache lines so that the two
+        // threads do not keep invalidating each other's copy. The padding
+        // keeps them a full line apart from each other and from whatever
+        // surrounds them; alignas would not be honoured by operator new
+        // before C++17.
+        char padding0_[CACHE_LINE_SIZE];
+        std::atomic<std::size_t> head_;
+        char padding1_[INDEX_PADDING];
+        std::atomic<std::size_t> tail_;
+        char padding2_[INDEX_PADDING];
+        T slots_[N];
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -0,0 +1,69 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Utf16Decoder.h"
+#include "Utf8Decoder.h"
+#include <cstdio>
+
+namespace klex
+{
+
+    Utf16Decoder::Utf16Decoder(bool big_endian)
+    : big_endian_{big_endian}
+    {
+    }
+
+    int Utf16Decoder::decode(char const*& it, char const* end) const
+    {
+        if (it == end)
+        {
+            return EOF;
+        }
+        if (end - it < 2)
+        {
+            ++it;
+            return Utf8Decoder::INVALID;
+        }
+
+        int result = code_unit(it);
+        it += 2;
+        if (result >= 0xD800 && result <= 0xDBFF)
+        {
+            int low = end - it < 2 ? 0 : code_unit(it);
+            if (low >= 0xDC00 && low <= 0xDFFF)
+            {
+                it += 2;
+                result = 0x10000 + ((result - 0xD800) << 10) + (low - 0xDC00);
+            }
+            else
+            {
+                result = Utf8Decoder::INVALID;
+            }
+        }
+        else if (result >= 0xDC00 && result <= 0xDFFF)
+        {
+            result = Utf8Decoder::INVALID;
+        }
+        return result;
+    }
+
+    int Utf16Decoder::code_unit(char const* it) const
+    {
+        int first = static_cast<unsigned char>(it[0]);
+        int second = static_cast<unsigned char>(it[1]);
+        return big_endian_ ? (first << 8) | second : (second << 8) | first;
+    }
+
+} // close klex namespace
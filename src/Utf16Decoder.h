@@ -0,0 +1,41 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UTF16DECODER_H_INCLUDED_5GQXH2VD
+#define UTF16DECODER_H_INCLUDED_5GQXH2VD
+
+namespace klex
+{
+
+    class Utf16Decoder
+    {
+    public:
+        explicit Utf16Decoder(bool big_endian);
+
+        // Reads from [it, end) and advances it past the consumed bytes.
+        // Unpaired surrogates and a trailing odd byte decode to
+        // Utf8Decoder::INVALID.
+        int decode(char const*& it, char const* end) const;
+
+        // The code unit in the two bytes at it.
+        int code_unit(char const* it) const;
+
+    private:
+        bool big_endian_;
+    };
+
+} // close klex namespace
+
+#endif // include guard
@@ -14,6 +14,9 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Utf8Decoder.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
 namespace klex
 {
@@ -21,25 +24,62 @@ namespace klex
     namespace
     {
 
-        int utf8_continue(std::istream& is, int current_value)
+        // Byte sources for utf8_decode(). get() returns EOF at the end, and
+        // unget() gives back a byte that does not continue a sequence.
+        class StreamBytes
         {
-            int result = is.get();
-            if ((result & 0xC0) == 0x80)
+        public:
+            explicit StreamBytes(std::istream& is)
+            : is_(is)
             {
-                result &= 0x3F;
-                result |= (current_value << 6);
             }
-            else
+
+            int get()
             {
-                is.putback(result);
-                result = Utf8Decoder::INVALID;
+                return is_.get();
             }
-            return result;
-        }
 
-        int utf8_continue(std::istream& is, int current_value, int min, int max)
+            void unget(int byte)
+            {
+                is_.putback(byte);
+            }
+
+        private:
+            std::istream& is_;
+        };
+
+        class RangeBytes
         {
-            int result = is.get();
+        public:
+            RangeBytes(char const*& it, char const* end)
+            : it_(it)
+            , end_{end}
+            {
+            }
+
+            int get()
+            {
+                return it_ == end_ ? EOF : static_cast<unsigned char>(*it_++);
+            }
+
+            void unget(int byte)
+            {
+                if (byte != EOF)
+                {
+                    --it_;
+                }
+            }
+
+        private:
+            char const*& it_;
+            char const* end_;
+        };
+
+        template <typename Bytes>
+        int utf8_continue(Bytes& bytes, int current_value, int min = 0x80,
+                          int max = 0xBF)
+        {
+            int result = bytes.get();
             if (result >= min && result <= max)
             {
                 result &= 0x3F;
@@ -47,86 +87,216 @@ namespace klex
             }
             else
             {
-                is.putback(result);
+                bytes.unget(result);
                 result = Utf8Decoder::INVALID;
             }
             return result;
         }
 
-    } // close unnamed namespace
-
-    int const Utf8Decoder::INVALID = 0xFFFD;
-
-    int Utf8Decoder::decode(std::istream& is) const
-    {
-        int result = is.get();
-
-        if ((result & 0x80) == 0x0 || result == EOF)
-        {
-            // nothing else needs to be done
-        }
-        else if ((result & 0xE0) == 0xC0)
+        template <typename Bytes>
+        int utf8_decode(Bytes& bytes)
         {
-            if (result == 0xC0 || result == 0xC1)
+            int result = bytes.get();
+
+            if ((result & 0x80) == 0x0 || result == EOF)
             {
-                result = Utf8Decoder::INVALID;
+                // nothing else needs to be done
             }
-            else
+            else if ((result & 0xE0) == 0xC0)
             {
-                result &= 0x1F;
-                result = utf8_continue(is, result);
+                if (result == 0xC0 || result == 0xC1)
+                {
+                    result = Utf8Decoder::INVALID;
+                }
+                else
+                {
+                    result = utf8_continue(bytes, result & 0x1F);
+                }
             }
-        }
-        else if ((result & 0xF0) == 0xE0)
-        {
-            int current_value = result & 0xF;
-            if (result == 0xE0)
+            else if ((result & 0xF0) == 0xE0)
             {
-                result = utf8_continue(is, current_value, 0xA0, 0xBF);
+                int current_value = result & 0xF;
+                if (result == 0xE0)
+                {
+                    result = utf8_continue(bytes, current_value, 0xA0, 0xBF);
+                }
+                else if (result == 0xED)
+                {
+                    result = utf8_continue(bytes, current_value, 0x80, 0x9F);
+                }
+                else
+                {
+                    result = utf8_continue(bytes, current_value);
+                }
+                if (result != Utf8Decoder::INVALID)
+                {
+                    result = utf8_continue(bytes, result);
+                }
             }
-            else if (result == 0xED)
+            else if (result <= 0xF4 && result >= 0xF0)
             {
-                result = utf8_continue(is, current_value, 0x80, 0x9F);
+                int current_value = result & 0x7;
+                if (result == 0xF0)
+                {
+                    result = utf8_continue(bytes, current_value, 0x90, 0xBF);
+                }
+                else if (result == 0xF4)
+                {
+                    result = utf8_continue(bytes, current_value, 0x80, 0x8F);
+                }
+                else
+                {
+                    result = utf8_continue(bytes, current_value);
+                }
+                if (result != Utf8Decoder::INVALID)
+                {
+                    result = utf8_continue(bytes, result);
+                    if (result != Utf8Decoder::INVALID)
+                    {
+                        result = utf8_continue(bytes, result);
+                    }
+                }
             }
             else
             {
-                result = utf8_continue(is, current_value);
-            }
-            if (result != Utf8Decoder::INVALID)
-            {
-                result = utf8_continue(is, result);
+                result = Utf8Decoder::INVALID;
             }
+            return result;
         }
-        else if (result <= 0xF4 && result >= 0xF0)
+
+        // Returns the length of the well-formed sequence starting at it, or
+        // 0 if the sequence is ill-formed or truncated by end.
+        int utf8_sequence_length(unsigned char const* it,
+                                 unsigned char const* end)
         {
-            int current_value = result & 0x7;
-            if (result == 0xF0)
+            unsigned char lead = it[0];
+            int length;
+            unsigned char min = 0x80;
+            unsigned char max = 0xBF;
+            if (lead >= 0xC2 && lead <= 0xDF)
+            {
+                length = 2;
+            }
+            else if (lead >= 0xE0 && lead <= 0xEF)
             {
-                result = utf8_continue(is, current_value, 0x90, 0xBF);
+                length = 3;
+                if (lead == 0xE0)
+                {
+                    min = 0xA0;
+                }
+                else if (lead == 0xED)
+                {
+                    max = 0x9F;
+                }
             }
-            else if (result == 0xF4)
+            else if (lead >= 0xF0 && lead <= 0xF4)
             {
-                result = utf8_continue(is, current_value, 0x80, 0x8F);
+                length = 4;
+                if (lead == 0xF0)
+                {
+                    min = 0x90;
+                }
+                else if (lead == 0xF4)
+                {
+                    max = 0x8F;
+                }
             }
             else
             {
-                result = utf8_continue(is, current_value);
+                return 0;
             }
-            if (result != Utf8Decoder::INVALID)
+            if (end - it < length || it[1] < min || it[1] > max)
             {
-                result = utf8_continue(is, result);
-                if (result != Utf8Decoder::INVALID)
+                return 0;
+            }
+            for (int i = 2; i < length; ++i)
+            {
+                if ((it[i] & 0xC0) != 0x80)
                 {
-                    result = utf8_continue(is, result);
+                    return 0;
                 }
             }
+            return length;
+        }
+
+    } // close unnamed namespace
+
+    int const Utf8Decoder::INVALID = 0xFFFD;
+
+    int Utf8Decoder::decode(std::istream& is) const
+    {
+        StreamBytes bytes{is};
+        return utf8_decode(bytes);
+    }
+
+    int Utf8Decoder::decode(char const*& it, char const* end) const
+    {
+        RangeBytes bytes{it, end};
+        return utf8_decode(bytes);
+    }
+
+    int Utf8Decoder::decode_unchecked(char const*& it) const
+    {
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(it);
+        int result = p[0];
+        if (result < 0x80)
+        {
+            it += 1;
+        }
+        else if (result < 0xE0)
+        {
+            result = ((result & 0x1F) << 6) | (p[1] & 0x3F);
+            it += 2;
+        }
+        else if (result < 0xF0)
+        {
+            result = ((result & 0xF) << 12) | ((p[1] & 0x3F) << 6) |
+                     (p[2] & 0x3F);
+            it += 3;
         }
         else
         {
-            result = Utf8Decoder::INVALID;
+            result = ((result & 0x7) << 18) | ((p[1] & 0x3F) << 12) |
+                     ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+            it += 4;
         }
         return result;
     }
 
-} // close klex namespace
+    char const* Utf8Decoder::validate(char const* begin, char const* end)
+    {
+        unsigned char const* it = reinterpret_cast<unsigned char const*>(begin);
+        unsigned char const* last = reinterpret_cast<unsigned char const*>(end);
+        while (it != last)
+        {
+            // skip ASCII eight bytes at a time
+            std::uint64_t word;
+            while (last - it >= 8)
+            {
+                std::memcpy(&word, it, sizeof(word));
+                if ((word & UINT64_C(0x8080808080808080)) != 0)
+                {
+                    break;
+                }
+                it += 8;
+            }
+            if (it == last)
+            {
+                break;
+            }
+            if (*it < 0x80)
+            {
+                ++it;
+                continue;
+            }
+            int length = utf8_sequence_length(it, last);
+            if (length == 0)
+            {
+                break;
+            }
+            it += length;
+        }
+        return reinterpret_cast<char const*>(it);
+    }
 
+} // close klex namespace
@@ -27,9 +27,20 @@ namespace klex
         static int const INVALID;
 
         int decode(std::istream& is) const;
+
+        // Same as above, but reads from [it, end) and advances it past
+        // the consumed bytes.
+        int decode(char const*& it, char const* end) const;
+
+        // Decodes a sequence that is known to be well-formed, e.g. one
+        // that lies within the range returned by validate().
+        int decode_unchecked(char const*& it) const;
+
+        // Returns the end of the longest prefix of [begin, end) made of
+        // complete, well-formed sequences.
+        static char const* validate(char const* begin, char const* end);
     };
 
 } // close klex namespace
 
 #endif // include guard
-
@@ -0,0 +1,67 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ZstdStreamBuf.h"
+#include <stdexcept>
+#include <string>
+
+namespace klex
+{
+
+    ZstdStreamBuf::ZstdStreamBuf(std::unique_ptr<std::istream>&& compressed)
+    : DecompressingStreamBuf{std::move(compressed)}
+    , context_{ZSTD_createDCtx()}
+    , frame_end_{false}
+    {
+        if (!context_)
+        {
+            throw std::runtime_error("ZstdStreamBuf: cannot create context");
+        }
+    }
+
+    ZstdStreamBuf::~ZstdStreamBuf()
+    {
+        ZSTD_freeDCtx(context_);
+    }
+
+    std::size_t ZstdStreamBuf::decompress(char* out, std::size_t size)
+    {
+        ZSTD_outBuffer output{out, size, 0};
+        while (output.pos == 0)
+        {
+            bool const more_input = read_input();
+            if (!more_input && frame_end_)
+            {
+                break;
+            }
+            ZSTD_inBuffer input{input_data(), input_size(), 0};
+            std::size_t result =
+                ZSTD_decompressStream(context_, &output, &input);
+            consume_input(input.pos);
+            if (ZSTD_isError(result))
+            {
+                throw std::runtime_error(std::string("ZstdStreamBuf: ") +
+                                         ZSTD_getErrorName(result));
+            }
+            frame_end_ = result == 0;
+            if (!more_input && output.pos == 0 && !frame_end_)
+            {
+                throw std::runtime_error("ZstdStreamBuf: truncated input");
+            }
+        }
+        return output.pos;
+    }
+
+} // close klex namespace
@@ -0,0 +1,49 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZSTDSTREAMBUF_H_INCLUDED_0FJC6PYS
+#define ZSTDSTREAMBUF_H_INCLUDED_0FJC6PYS
+
+#include "DecompressingStreamBuf.h"
+#include <zstd.h>
+
+namespace klex
+{
+
+    // Decompresses zstd data, including concatenated frames. Only available
+    // if klex was built with libzstd (KLEX_HAVE_ZSTD).
+    class ZstdStreamBuf : public DecompressingStreamBuf
+    {
+    public:
+        explicit ZstdStreamBuf(std::unique_ptr<std::istream>&& compressed);
+
+        ~ZstdStreamBuf();
+
+        ZstdStreamBuf(ZstdStreamBuf const&) = delete;
+        ZstdStreamBuf& operator=(ZstdStreamBuf const&) = delete;
+
+    protected:
+        std::size_t decompress(char* out, std::size_t size) override;
+
+    private:
+        ZSTD_DCtx* context_;
+        bool frame_end_;
+    };
+
+    typedef DecompressingStream<ZstdStreamBuf> ZstdStream;
+
+} // close klex namespace
+
+#endif // include guard
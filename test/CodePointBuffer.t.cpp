@@ -108,3 +108,44 @@ TEST(CodePointBuffer, index)
     ASSERT_EQ(2, b[1]);
 }
 
+TEST(CodePointBuffer, front_offset)
+{
+    klex::CodePointBuffer b;
+    b.push_back('a', 1);
+    b.push_back(0x03ba, 3);
+    ASSERT_EQ(1u, b.front_offset());
+    b.pop_front();
+    ASSERT_EQ(3u, b.front_offset());
+}
+
+TEST(CodePointBuffer, set_back_offset)
+{
+    klex::CodePointBuffer b;
+    b.push_back('\r', 1);
+    b.set_back_offset(2);
+    ASSERT_EQ(2u, b.front_offset());
+}
+
+TEST(CodePointBuffer, clear)
+{
+    klex::CodePointBuffer b;
+    b.push_back(1);
+    b.push_back(2);
+    b.clear();
+    ASSERT_TRUE(b.empty());
+}
+
+TEST(CodePointBuffer, index_wrap_around)
+{
+    klex::CodePointBuffer b;
+    for (int i = 0; i < 200; ++i)
+    {
+        b.push_back(i);
+        b.pop_front();
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        b.push_back(i);
+    }
+    ASSERT_EQ(99, b[99]);
+}
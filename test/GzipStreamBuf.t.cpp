@@ -0,0 +1,115 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/GzipStreamBuf.h"
+#include "../src/InputStream.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+
+namespace
+{
+
+    std::string gzip(std::string const& str)
+    {
+        z_stream stream{};
+        // 16 selects the gzip format
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY);
+        std::string result(deflateBound(&stream, str.size()), '\0');
+        stream.next_in =
+            reinterpret_cast<Bytef*>(const_cast<char*>(str.data()));
+        stream.avail_in = str.size();
+        stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+        stream.avail_out = result.size();
+        deflate(&stream, Z_FINISH);
+        result.resize(stream.total_out);
+        deflateEnd(&stream);
+        return result;
+    }
+
+    std::unique_ptr<std::istream> make_stream(std::string const& str)
+    {
+        return std::unique_ptr<std::istream>(new klex::GzipStream(
+            std::unique_ptr<std::istream>(new std::istringstream(str))));
+    }
+
+    std::string read_all(std::istream& is)
+    {
+        std::ostringstream os;
+        os << is.rdbuf();
+        return os.str();
+    }
+
+} // close unnamed namespace
+
+TEST(GzipStreamBuf, bulk_read)
+{
+    std::string str;
+    for (int i = 0; i < 200000; ++i)
+    {
+        str += static_cast<char>('a' + i % 23);
+    }
+    auto is = make_stream(gzip(str));
+    std::string result(str.size() + 10, '\0');
+    is->read(&result[0], result.size());
+    ASSERT_EQ(str.size(), static_cast<std::size_t>(is->gcount()));
+    result.resize(is->gcount());
+    ASSERT_EQ(str, result);
+}
+
+TEST(GzipStreamBuf, character_read)
+{
+    auto is = make_stream(gzip("abc"));
+    ASSERT_EQ('a', is->get());
+    ASSERT_EQ('b', is->peek());
+    char rest[4];
+    is->read(rest, sizeof(rest));
+    ASSERT_EQ(2, is->gcount());
+    ASSERT_EQ("bc", std::string(rest, 2));
+}
+
+TEST(GzipStreamBuf, concatenated_members)
+{
+    auto is = make_stream(gzip("abc") + gzip("def"));
+    ASSERT_EQ("abcdef", read_all(*is));
+}
+
+TEST(GzipStreamBuf, truncated_input)
+{
+    std::string compressed = gzip("abcdefgh");
+    auto is = make_stream(compressed.substr(0, compressed.size() - 4));
+    char buffer[16];
+    ASSERT_THROW(is->read(buffer, sizeof(buffer)), std::runtime_error);
+}
+
+TEST(GzipStreamBuf, corrupt_input)
+{
+    auto is = make_stream("definitely not gzip");
+    char buffer[16];
+    ASSERT_THROW(is->read(buffer, sizeof(buffer)), std::runtime_error);
+}
+
+TEST(GzipStreamBuf, input_stream)
+{
+    klex::InputStream is(make_stream(gzip("a\r\n\xce\xba")));
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ(0x03ba, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
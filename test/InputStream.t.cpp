@@ -17,6 +17,8 @@
 #include <gtest/gtest.h>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
 
 namespace
@@ -27,6 +29,49 @@ namespace
         return std::unique_ptr<std::istream>(new std::istringstream(str));
     }
 
+    // Serves one character at a time and throws once drained, standing in
+    // for a pipe that would block waiting for more input.
+    class TrickleBuffer : public std::streambuf
+    {
+    public:
+        explicit TrickleBuffer(std::string const& str)
+            : str_(str)
+            , pos_{}
+        {
+        }
+
+    protected:
+        int_type underflow() override
+        {
+            if (pos_ == str_.size())
+            {
+                throw std::runtime_error("would block");
+            }
+            setg(&str_[pos_], &str_[pos_], &str_[pos_] + 1);
+            ++pos_;
+            return traits_type::to_int_type(*gptr());
+        }
+
+    private:
+        std::string str_;
+        std::size_t pos_;
+    };
+
+    class TrickleStream : public std::istream
+    {
+    public:
+        explicit TrickleStream(std::string const& str)
+            : std::istream(nullptr)
+            , buffer_(str)
+        {
+            rdbuf(&buffer_);
+            exceptions(std::ios_base::badbit);
+        }
+
+    private:
+        TrickleBuffer buffer_;
+    };
+
 } // close unnamed namespace
 
 TEST(InputStream, simple_get)
@@ -159,3 +204,390 @@ TEST(InputStream, new_line_4)
     ASSERT_EQ(1, is.get_column());
 }
 
+TEST(InputStream, sequence_across_chunks)
+{
+    for (std::size_t prefix = 16 * 1024 - 4; prefix <= 16 * 1024; ++prefix)
+    {
+        std::string str(prefix, 'a');
+        str += "\xf0\xa4\xad\xa2\xe1\xbd\xb9";
+        klex::InputStream is(make_stream(str));
+        for (std::size_t i = 0; i < prefix; ++i)
+        {
+            ASSERT_EQ('a', is.get());
+        }
+        ASSERT_EQ(0x24b62, is.get());
+        ASSERT_EQ(0x1f79, is.get());
+        ASSERT_EQ(EOF, is.get());
+    }
+}
+
+TEST(InputStream, does_not_wait_for_full_chunk)
+{
+    klex::InputStream is(std::unique_ptr<std::istream>(
+        new TrickleStream("a\xce\xba" "b")));
+    // get() looks one code point ahead
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ(0x03ba, is.get());
+    ASSERT_THROW(is.get(), std::runtime_error);
+}
+
+TEST(InputStream, invalid_sequence_after_valid_text)
+{
+    std::string str(100, 'a');
+    str += "\xC2\x41\xce\xba\xF0\x90\x80";
+    klex::InputStream is(make_stream(str));
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_EQ('a', is.get());
+    }
+    ASSERT_EQ(0xFFFD, is.get());
+    ASSERT_EQ(0x41, is.get());
+    ASSERT_EQ(0x03ba, is.get());
+    ASSERT_EQ(0xFFFD, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, detect_utf8_bom)
+{
+    klex::InputStream is(make_stream("\xEF\xBB\xBF\xce\xba"),
+                         klex::Encoding::detect);
+    ASSERT_EQ(0x03ba, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, detect_no_bom)
+{
+    klex::InputStream is(make_stream("ab"), klex::Encoding::detect);
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, detect_utf16le_bom)
+{
+    klex::InputStream is(make_stream(std::string("\xFF\xFE" "a\0\r\0\n\0"
+                                                 "\x52\xD8\x62\xDF", 12)),
+                         klex::Encoding::detect);
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ(2, is.get_line());
+    ASSERT_EQ(0x24b62, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, detect_utf16be_bom)
+{
+    klex::InputStream is(make_stream(std::string("\xFE\xFF\0a\x03\xba", 6)),
+                         klex::Encoding::detect);
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ(0x03ba, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, utf16_across_chunks)
+{
+    std::string str;
+    for (int i = 0; i < 8 * 1024 - 1; ++i)
+    {
+        str += std::string("a\0", 2);
+    }
+    str += "\x52\xD8\x62\xDF";
+    klex::InputStream is(make_stream(str), klex::Encoding::utf16le);
+    for (int i = 0; i < 8 * 1024 - 1; ++i)
+    {
+        ASSERT_EQ('a', is.get());
+    }
+    ASSERT_EQ(0x24b62, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, latin1)
+{
+    klex::InputStream is(make_stream("\xE9t\xE9\xFF"), klex::Encoding::latin1);
+    ASSERT_EQ(0xE9, is.get());
+    ASSERT_EQ('t', is.get());
+    ASSERT_EQ(0xE9, is.get());
+    ASSERT_EQ(0xFF, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, latin1_across_chunks)
+{
+    // the carriage return is the last byte of the first chunk
+    std::string str(16 * 1024 - 1, '\xE9');
+    str += "\r\nx\ry";
+    klex::InputStream is(make_stream(str), klex::Encoding::latin1);
+    for (int i = 0; i < 16 * 1024 - 1; ++i)
+    {
+        ASSERT_EQ(0xE9, is.get());
+        ASSERT_EQ(i + 1u, is.get_offset());
+    }
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('x', is.peek(0));
+    ASSERT_EQ('x', is.get());
+    ASSERT_EQ(2, is.get_line());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('y', is.get());
+    ASSERT_EQ(3, is.get_line());
+    ASSERT_EQ(16 * 1024u + 4, is.get_offset());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, get_offset)
+{
+    klex::InputStream is(make_stream("a\xce\xba\r\nb"));
+    ASSERT_EQ(0u, is.get_offset());
+    is.get();
+    ASSERT_EQ(1u, is.get_offset());
+    is.get();
+    ASSERT_EQ(3u, is.get_offset());
+    ASSERT_EQ('\n', is.peek(0));
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ(5u, is.get_offset());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ(6u, is.get_offset());
+}
+
+TEST(InputStream, snapshots)
+{
+    klex::InputStream is(make_stream("a\nb\r\nc\rd\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+        is.set_state(is.get_line() * 10);
+    }
+    auto const& snapshots = is.get_snapshots();
+    ASSERT_EQ(5u, snapshots.size());
+    ASSERT_EQ(0u, snapshots[0].offset);
+    ASSERT_EQ(1, snapshots[0].line);
+    ASSERT_EQ(2u, snapshots[1].offset);
+    ASSERT_EQ(2, snapshots[1].line);
+    ASSERT_EQ(10, snapshots[1].state);
+    ASSERT_EQ(5u, snapshots[2].offset);
+    ASSERT_EQ(3, snapshots[2].line);
+    ASSERT_EQ(7u, snapshots[3].offset);
+    ASSERT_EQ(4, snapshots[3].line);
+    ASSERT_EQ(9u, snapshots[4].offset);
+    ASSERT_EQ(5, snapshots[4].line);
+}
+
+TEST(InputStream, snapshot_interval)
+{
+    klex::InputStream is(make_stream("a\nb\nc\nd\ne\n"));
+    is.set_snapshot_interval(2);
+    while (is.get() != EOF)
+    {
+    }
+    auto const& snapshots = is.get_snapshots();
+    ASSERT_EQ(3u, snapshots.size());
+    ASSERT_EQ(1, snapshots[0].line);
+    ASSERT_EQ(3, snapshots[1].line);
+    ASSERT_EQ(5, snapshots[2].line);
+}
+
+TEST(InputStream, resume)
+{
+    klex::InputStream is(make_stream("a\r\nb\nc\nd\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+        is.set_state(is.get_line());
+    }
+    // replace "\nc" with "\nx\ny"
+    auto snapshot = is.resume(make_stream("a\r\nb\nx\ny\nd\n"), 5, 1, 3);
+    ASSERT_EQ(3u, snapshot.offset);
+    ASSERT_EQ(2, snapshot.line);
+    ASSERT_EQ(1, is.get_state());
+    ASSERT_EQ(4u, is.get_snapshots().size());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('x', is.get());
+    ASSERT_EQ(3, is.get_line());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('y', is.get());
+    ASSERT_EQ(4, is.get_line());
+    ASSERT_EQ(7u, is.get_snapshots()[3].offset);
+    // the returned snapshot is a copy and survives new snapshots
+    ASSERT_EQ(3u, snapshot.offset);
+}
+
+TEST(InputStream, resume_keeps_later_snapshots)
+{
+    klex::InputStream is(make_stream("a\nb\nc\nd\ne\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    // replace "b" with "x\ny"
+    is.resume(make_stream("a\nx\ny\nc\nd\ne\n"), 2, 1, 3);
+    auto const& snapshots = is.get_snapshots();
+    ASSERT_EQ(5u, snapshots.size());
+    ASSERT_EQ(6u, snapshots[1].offset);
+    ASSERT_EQ(12u, snapshots[4].offset);
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('x', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_FALSE(is.is_synchronized());
+    ASSERT_EQ('y', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_TRUE(is.is_synchronized());
+    ASSERT_EQ(7u, snapshots.size());
+    for (std::size_t i = 0; i < snapshots.size(); ++i)
+    {
+        ASSERT_EQ(2 * i, snapshots[i].offset);
+        ASSERT_EQ(2 * i, snapshots[i].position);
+        ASSERT_EQ(static_cast<int>(i) + 1, snapshots[i].line);
+    }
+}
+
+TEST(InputStream, resume_in_other_state)
+{
+    klex::InputStream is(make_stream("a\nb\nc\nd\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    // remove the line break after "a"
+    is.resume(make_stream("ab\nc\nd\n"), 1, 1, 0);
+    is.set_state(1);
+    ASSERT_EQ(4u, is.get_snapshots().size());
+    while (is.get() != EOF)
+    {
+        ASSERT_FALSE(is.is_synchronized());
+    }
+    auto const& snapshots = is.get_snapshots();
+    ASSERT_EQ(4u, snapshots.size());
+    ASSERT_EQ(3u, snapshots[1].offset);
+    ASSERT_EQ(2, snapshots[1].line);
+    ASSERT_EQ(4, snapshots[3].line);
+    ASSERT_EQ(0, snapshots[3].state);
+}
+
+TEST(InputStream, resume_twice)
+{
+    klex::InputStream is(make_stream("a\nb\nc\nd\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    // insert "x\n" after the first line, then edit "d" before relexing
+    is.resume(make_stream("a\nx\nb\nc\nd\n"), 2, 0, 2);
+    auto snapshot = is.resume(make_stream("a\nx\nb\nc\ne\n"), 8, 1, 1);
+    // the snapshot kept at "c" still has the line number from before the
+    // first edit
+    ASSERT_EQ(0u, snapshot.offset);
+    ASSERT_EQ(1, snapshot.line);
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(6, is.get_line());
+}
+
+TEST(InputStream, resume_after_crlf)
+{
+    klex::InputStream is(make_stream("a\r\nbc"));
+    is.set_snapshot_interval(1);
+    is.get();
+    is.get();
+    ASSERT_EQ(3u, is.get_snapshots().back().offset);
+    is.resume(make_stream("a\r\nbd"), 4, 1, 1);
+    ASSERT_EQ(2, is.get_line());
+    ASSERT_EQ(3u, is.get_offset());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ('d', is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, resume_from_start)
+{
+    klex::InputStream is(make_stream("\xEF\xBB\xBF" "ab"),
+                         klex::Encoding::detect);
+    is.get();
+    is.resume(make_stream(std::string("\xFF\xFE" "c\0", 4)), 0, 5, 4);
+    ASSERT_EQ('c', is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(InputStream, invalid_sequences)
+{
+    std::string str(100, 'a');
+    str += "\xC2\x41\xEF\xBF\xBD\xF0\x90\x80";
+    klex::InputStream is(make_stream(str));
+    while (is.get() != EOF)
+    {
+    }
+    auto const& invalid = is.get_invalid_sequences();
+    ASSERT_EQ(2u, invalid.size());
+    ASSERT_EQ(100u, invalid[0].offset);
+    ASSERT_EQ(1u, invalid[0].length);
+    ASSERT_EQ(105u, invalid[1].offset);
+    ASSERT_EQ(3u, invalid[1].length);
+}
+
+TEST(InputStream, invalid_sequences_utf16)
+{
+    klex::InputStream is(make_stream(std::string("\xFD\xFF\x00\xDC" "a", 5)),
+                         klex::Encoding::utf16le);
+    ASSERT_EQ(0xFFFD, is.get());
+    ASSERT_EQ(0xFFFD, is.get());
+    ASSERT_EQ(0xFFFD, is.get());
+    ASSERT_EQ(EOF, is.get());
+    auto const& invalid = is.get_invalid_sequences();
+    ASSERT_EQ(2u, invalid.size());
+    ASSERT_EQ(2u, invalid[0].offset);
+    ASSERT_EQ(2u, invalid[0].length);
+    ASSERT_EQ(4u, invalid[1].offset);
+    ASSERT_EQ(1u, invalid[1].length);
+}
+
+TEST(InputStream, invalid_sequences_resume)
+{
+    klex::InputStream is(make_stream("\x80\n\x80\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(2u, is.get_invalid_sequences().size());
+    is.resume(make_stream("\x80\nb\n"), 2, 1, 1);
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(1u, is.get_invalid_sequences().size());
+    ASSERT_EQ(0u, is.get_invalid_sequences()[0].offset);
+}
+
+TEST(InputStream, invalid_sequences_resume_past_edit)
+{
+    klex::InputStream is(make_stream("\x80\na\n\x80\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    is.resume(make_stream("\x80\nbb\n\x80\n"), 2, 1, 2);
+    ASSERT_EQ(1u, is.get_invalid_sequences().size());
+    ASSERT_EQ(5u, is.get_invalid_sequences()[0].offset);
+    while (is.get() != EOF)
+    {
+    }
+    auto const& invalid = is.get_invalid_sequences();
+    ASSERT_EQ(2u, invalid.size());
+    ASSERT_EQ(0u, invalid[0].offset);
+    ASSERT_EQ(5u, invalid[1].offset);
+}
+
+TEST(InputStream, invalid_sequences_made_valid_past_edit)
+{
+    klex::InputStream is(make_stream("ab\n\x82\xAC\nc\n"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(2u, is.get_invalid_sequences().size());
+    is.resume(make_stream("ab\n\xE2\x82\xAC\nc\n"), 3, 0, 1);
+    while (!is.is_synchronized())
+    {
+        ASSERT_NE(EOF, is.get());
+    }
+    ASSERT_TRUE(is.get_invalid_sequences().empty());
+}
@@ -0,0 +1,300 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/InputStream.h"
+#include "../src/LocationTable.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(SourceLocation, encoding)
+{
+    klex::SourceLocation location{12345};
+    ASSERT_EQ(4u, sizeof(location));
+    ASSERT_EQ(12345u, location.get_raw());
+    ASSERT_TRUE(location.is_valid());
+    ASSERT_FALSE(klex::SourceLocation{}.is_valid());
+}
+
+TEST(LocationTable, file_names)
+{
+    klex::LocationTable table;
+    auto a = table.add_file("a.txt", 10);
+    auto b = table.add_file("b.txt", 0);
+    ASSERT_EQ(1u, a);
+    ASSERT_EQ(2u, b);
+    ASSERT_EQ("a.txt", table.get_file_name(a));
+    ASSERT_EQ("b.txt", table.get_file_name(b));
+    ASSERT_THROW(table.get_file_name(0), std::out_of_range);
+    ASSERT_THROW(table.get_file_name(3), std::out_of_range);
+}
+
+TEST(LocationTable, file_ranges)
+{
+    klex::LocationTable table;
+    auto a = table.add_file("a.txt", 10);
+    auto b = table.add_file("b.txt", 0);
+    auto c = table.add_file("c.txt", 5);
+    ASSERT_EQ(1u, table.get_location(a, 0).get_raw());
+    ASSERT_EQ(11u, table.get_location(a, 10).get_raw());
+    ASSERT_EQ(12u, table.get_location(b, 0).get_raw());
+    ASSERT_EQ(13u, table.get_location(c, 0).get_raw());
+    ASSERT_THROW(table.get_location(a, 11), std::out_of_range);
+    ASSERT_EQ(a, table.get_file(table.get_location(a, 10)));
+    ASSERT_EQ(b, table.get_file(table.get_location(b, 0)));
+    ASSERT_EQ(c, table.get_file(table.get_location(c, 5)));
+    ASSERT_THROW(table.get_file(klex::SourceLocation{}), std::out_of_range);
+    ASSERT_THROW(table.get_file(klex::SourceLocation{19}), std::out_of_range);
+}
+
+TEST(LocationTable, out_of_locations)
+{
+    klex::LocationTable table;
+    table.add_file("a.txt", UINT32_MAX - 1);
+    ASSERT_THROW(table.add_file("b.txt", 0), std::length_error);
+}
+
+TEST(LocationTable, lines_and_columns)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 9);
+    table.replace_lines(file, 2, 2, {4, 5}, 0);
+    ASSERT_EQ(1, table.get_line(table.get_location(file, 0)));
+    ASSERT_EQ(1, table.get_column(table.get_location(file, 0)));
+    ASSERT_EQ(1, table.get_line(table.get_location(file, 3)));
+    ASSERT_EQ(4, table.get_column(table.get_location(file, 3)));
+    ASSERT_EQ(2, table.get_line(table.get_location(file, 4)));
+    ASSERT_EQ(1, table.get_column(table.get_location(file, 4)));
+    ASSERT_EQ(3, table.get_line(table.get_location(file, 9)));
+    ASSERT_EQ(5, table.get_column(table.get_location(file, 9)));
+}
+
+TEST(LocationTable, replace_lines)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 20);
+    table.replace_lines(file, 2, 2, {2, 4, 6}, 0);
+    // lines 2 and 3 become three lines, and the rest moves by one
+    table.replace_lines(file, 2, 4, {2, 3, 5}, 1);
+    ASSERT_EQ(3, table.get_line(table.get_location(file, 3)));
+    ASSERT_EQ(4, table.get_line(table.get_location(file, 6)));
+    ASSERT_EQ(5, table.get_line(table.get_location(file, 7)));
+    ASSERT_EQ(2, table.get_column(table.get_location(file, 8)));
+    // drop everything from line 3 on
+    table.replace_lines(file, 3, std::numeric_limits<int>::max(), {}, 0);
+    ASSERT_EQ(2, table.get_line(table.get_location(file, 20)));
+}
+
+TEST(LocationTable, input_stream)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 10);
+    klex::InputStream is(std::unique_ptr<std::istream>(
+        new std::istringstream("ab\r\n\xce\xba" "c\rd")));
+    is.set_location_table(table, file);
+    std::vector<klex::SourceLocation> locations;
+    do
+    {
+        locations.push_back(is.get_location());
+    } while (is.get() != EOF);
+
+    ASSERT_EQ(8u, locations.size());
+    int const expected[][2] = {
+        {1, 1}, {1, 2}, {1, 3}, {2, 1}, {2, 2}, {2, 3}, {3, 1}, {3, 2}};
+    for (std::size_t i = 0; i < locations.size(); ++i)
+    {
+        ASSERT_EQ(expected[i][0], table.get_line(locations[i]));
+        ASSERT_EQ(expected[i][1], table.get_column(locations[i]));
+    }
+}
+
+TEST(LocationTable, input_stream_past_file_size)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 2);
+    klex::InputStream is(std::unique_ptr<std::istream>(
+        new std::istringstream("abc")));
+    is.set_location_table(table, file);
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ(3, table.get_column(is.get_location()));
+    ASSERT_EQ('c', is.get());
+    ASSERT_THROW(is.get_location(), std::out_of_range);
+}
+
+TEST(LocationTable, input_stream_resume)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 7);
+    klex::InputStream is(std::unique_ptr<std::istream>(
+        new std::istringstream("a\nb\nc\nd")));
+    is.set_location_table(table, file);
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    is.resume(std::unique_ptr<std::istream>(
+                  new std::istringstream("a\nbbb")), 3, 4, 2);
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ('b', is.get());
+    auto location = is.get_location();
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(2, table.get_line(location));
+    ASSERT_EQ(3, table.get_column(location));
+    ASSERT_EQ(2, table.get_line(is.get_location()));
+}
+
+TEST(LocationTable, input_stream_synchronized)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 14);
+    {
+        klex::InputStream is(std::unique_ptr<std::istream>(
+            new std::istringstream("a\nb\nc\nd\ne\n")));
+        is.set_location_table(table, file);
+        is.set_snapshot_interval(1);
+        while (is.get() != EOF)
+        {
+        }
+        // insert "x\n" after the first line and stop relexing early
+        is.resume(std::unique_ptr<std::istream>(
+                      new std::istringstream("a\nx\nb\nc\nd\ne\n")),
+                  2, 0, 2);
+        while (!is.is_synchronized())
+        {
+            ASSERT_NE(EOF, is.get());
+        }
+        ASSERT_EQ(4, is.get_line());
+    }
+    ASSERT_EQ(2, table.get_line(table.get_location(file, 2)));
+    ASSERT_EQ(3, table.get_line(table.get_location(file, 4)));
+    ASSERT_EQ(6, table.get_line(table.get_location(file, 10)));
+    ASSERT_EQ(7, table.get_line(table.get_location(file, 12)));
+}
+
+TEST(LocationTable, input_stream_resume_past_synchronized)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 10);
+    klex::InputStream is(std::unique_ptr<std::istream>(
+        new std::istringstream("a\nb\nc\nd\ne\n")));
+    is.set_location_table(table, file);
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    is.resume(std::unique_ptr<std::istream>(
+                  new std::istringstream("a\nx\nc\nd\ne\n")), 2, 1, 1);
+    while (!is.is_synchronized())
+    {
+        ASSERT_NE(EOF, is.get());
+    }
+    // resumes from a snapshot past the lines read since the first edit
+    is.resume(std::unique_ptr<std::istream>(
+                  new std::istringstream("a\nx\nc\nd\ne\n")), 8, 0, 0);
+    while (is.get() != EOF)
+    {
+    }
+    for (int line = 1; line <= 5; ++line)
+    {
+        ASSERT_EQ(line, table.get_line(
+                            table.get_location(file, 2 * (line - 1))));
+    }
+}
+
+TEST(LocationTable, source_file_lines)
+{
+    std::string const str = "a\nb\r\n\xce\xba\xC0\rc\n\nd";
+    auto source = std::make_shared<klex::SourceFile>(
+        "a.txt", std::vector<char>(str.begin(), str.end()));
+    klex::LocationTable table;
+    auto indexed = table.add_file(*source);
+    auto decoded = table.add_file("b.txt", str.size());
+    {
+        klex::InputStream is(std::unique_ptr<std::istream>(
+            new std::istringstream(str)));
+        is.set_location_table(table, decoded);
+        while (is.get() != EOF)
+        {
+        }
+    }
+    for (std::uint64_t position = 0; position <= str.size(); ++position)
+    {
+        auto expected = table.get_location(decoded, position);
+        auto actual = table.get_location(indexed, position);
+        ASSERT_EQ(table.get_line(expected), table.get_line(actual));
+        ASSERT_EQ(table.get_column(expected), table.get_column(actual));
+    }
+}
+
+TEST(LocationTable, input_stream_source_file)
+{
+    auto source = std::make_shared<klex::SourceFile>(
+        "a.txt", std::vector<char>{'a', '\n', 'b', '\n', 'c'});
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", source->size());
+    klex::InputStream is(source);
+    is.set_location_table(table, file);
+    // the lines are known before anything is read
+    ASSERT_EQ(3, table.get_line(table.get_location(file, 4)));
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(2, table.get_line(table.get_location(file, 2)));
+    ASSERT_EQ(3, table.get_line(table.get_location(file, 4)));
+    is.resume(std::make_shared<klex::SourceFile>(
+                  "a.txt", std::vector<char>{'a', '\n', 'c'}),
+              2, 2, 0);
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(2, table.get_line(table.get_location(file, 2)));
+    ASSERT_EQ(2, table.get_line(table.get_location(file, 3)));
+}
+
+TEST(LocationTable, input_stream_batches)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 6000);
+    std::string str;
+    for (int i = 0; i < 3000; ++i)
+    {
+        str += "a\n";
+    }
+    klex::InputStream is(std::unique_ptr<std::istream>(
+        new std::istringstream(str)));
+    is.set_location_table(table, file);
+    std::vector<klex::SourceLocation> locations;
+    int code_point;
+    while ((code_point = is.get()) != EOF)
+    {
+        if (code_point == '\n')
+        {
+            locations.push_back(is.get_location());
+        }
+    }
+    ASSERT_EQ(3000u, locations.size());
+    for (std::size_t i = 0; i < locations.size(); ++i)
+    {
+        ASSERT_EQ(static_cast<int>(i) + 2, table.get_line(locations[i]));
+        ASSERT_EQ(1, table.get_column(locations[i]));
+    }
+}
@@ -0,0 +1,144 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/NfcNormalizer.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace
+{
+
+    typedef klex::NfcNormalizer::QuickCheck QuickCheck;
+
+    QuickCheck quick_check(std::vector<int> const& in)
+    {
+        return klex::NfcNormalizer{}.quick_check(in.data(),
+                                                 in.data() + in.size());
+    }
+
+    // Returns the input itself if it is already normalized.
+    std::vector<int> normalize(std::vector<int> const& in)
+    {
+        std::vector<int> out;
+        if (klex::NfcNormalizer{}.normalize(in.data(), in.data() + in.size(),
+                                            out))
+        {
+            return in;
+        }
+        return out;
+    }
+
+} // close unnamed namespace
+
+TEST(NfcNormalizer, ascii)
+{
+    std::vector<int> in{'a', 'b', 'c'};
+    std::vector<int> out{42};
+    ASSERT_EQ(QuickCheck::yes, quick_check(in));
+    ASSERT_TRUE(klex::NfcNormalizer{}.normalize(in.data(),
+                                                in.data() + in.size(), out));
+    ASSERT_EQ(std::vector<int>{42}, out);
+}
+
+TEST(NfcNormalizer, empty)
+{
+    std::vector<int> in;
+    ASSERT_EQ(QuickCheck::yes, quick_check(in));
+    ASSERT_EQ(in, normalize(in));
+}
+
+TEST(NfcNormalizer, precomposed)
+{
+    // é, κ, ό
+    std::vector<int> in{0xE9, 0x03BA, 0x1F79};
+    ASSERT_EQ(QuickCheck::no, quick_check(in));
+    std::vector<int> expected{0xE9, 0x03BA, 0x03CC};
+    ASSERT_EQ(expected, normalize(in));
+}
+
+TEST(NfcNormalizer, combining_sequence)
+{
+    std::vector<int> in{'x', 'e', 0x0301, 'y'};
+    ASSERT_EQ(QuickCheck::maybe, quick_check(in));
+    std::vector<int> expected{'x', 0xE9, 'y'};
+    ASSERT_EQ(expected, normalize(in));
+}
+
+TEST(NfcNormalizer, maybe_but_normalized)
+{
+    // U+0301 cannot compose with 'x'
+    std::vector<int> in{'x', 0x0301};
+    ASSERT_EQ(QuickCheck::maybe, quick_check(in));
+    std::vector<int> out;
+    ASSERT_TRUE(klex::NfcNormalizer{}.normalize(in.data(),
+                                                in.data() + in.size(), out));
+    ASSERT_TRUE(out.empty());
+}
+
+TEST(NfcNormalizer, canonical_ordering)
+{
+    // dot below (220) must come before the acute accent (230)
+    std::vector<int> in{'q', 0x0301, 0x0323};
+    ASSERT_EQ(QuickCheck::no, quick_check(in));
+    std::vector<int> expected{'q', 0x0323, 0x0301};
+    ASSERT_EQ(expected, normalize(in));
+}
+
+TEST(NfcNormalizer, blocked_composition)
+{
+    // a + dot below + acute: the acute is not blocked by the dot below
+    std::vector<int> in{'a', 0x0301, 0x0323};
+    std::vector<int> expected{0x1EA1, 0x0301};
+    ASSERT_EQ(expected, normalize(in));
+}
+
+TEST(NfcNormalizer, singleton)
+{
+    // ANGSTROM SIGN
+    std::vector<int> in{0x212B};
+    ASSERT_EQ(QuickCheck::no, quick_check(in));
+    ASSERT_EQ(std::vector<int>{0xC5}, normalize(in));
+}
+
+TEST(NfcNormalizer, composition_exclusion)
+{
+    // U+0958 DEVANAGARI LETTER QA never recomposes
+    std::vector<int> in{0x0958};
+    std::vector<int> expected{0x0915, 0x093C};
+    ASSERT_EQ(expected, normalize(in));
+}
+
+TEST(NfcNormalizer, hangul)
+{
+    std::vector<int> in{0x1100, 0x1161, 0x11A8, 0xAC00, 0x11A8};
+    ASSERT_EQ(QuickCheck::maybe, quick_check(in));
+    std::vector<int> expected{0xAC01, 0xAC01};
+    ASSERT_EQ(expected, normalize(in));
+}
+
+TEST(NfcNormalizer, keeps_prefix)
+{
+    std::vector<int> in{0xE9, 'a', 'b', 'o', 0x0308};
+    std::vector<int> expected{0xE9, 'a', 'b', 0xF6};
+    ASSERT_EQ(expected, normalize(in));
+}
+
+TEST(NfcNormalizer, reorder_into_precomposed)
+{
+    // H with caron followed by dot below becomes H with dot below + caron
+    std::vector<int> in{0x021E, 0x0323};
+    std::vector<int> expected{0x1E24, 0x030C};
+    ASSERT_EQ(expected, normalize(in));
+}
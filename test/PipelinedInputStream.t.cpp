@@ -0,0 +1,240 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/LocationTable.h"
+#include "../src/PipelinedInputStream.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace
+{
+
+    std::unique_ptr<klex::InputStream> make_input(std::string const& str)
+    {
+        return std::unique_ptr<klex::InputStream>(new klex::InputStream(
+            std::unique_ptr<std::istream>(new std::istringstream(str))));
+    }
+
+    class FailingBuffer : public std::streambuf
+    {
+    protected:
+        int_type underflow() override
+        {
+            throw std::runtime_error("read error");
+        }
+    };
+
+    // Hands out one character at a time, slowly enough for the consumer
+    // to give up spinning and block.
+    class SlowBuffer : public std::streambuf
+    {
+    public:
+        explicit SlowBuffer(std::string str)
+        : str_{std::move(str)}
+        , pos_{0}
+        , current_{0}
+        {
+        }
+
+    protected:
+        int_type underflow() override
+        {
+            if (pos_ == str_.size())
+            {
+                return traits_type::eof();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            current_ = str_[pos_++];
+            setg(&current_, &current_, &current_ + 1);
+            return traits_type::to_int_type(current_);
+        }
+
+    private:
+        std::string str_;
+        std::size_t pos_;
+        char current_;
+    };
+
+} // close unnamed namespace
+
+TEST(PipelinedInputStream, simple_get)
+{
+    klex::PipelinedInputStream is(make_input("abc"));
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ('c', is.get());
+    ASSERT_EQ(EOF, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(PipelinedInputStream, simple_peek)
+{
+    klex::PipelinedInputStream is(make_input("abc"));
+    ASSERT_EQ('a', is.peek(0));
+    ASSERT_EQ('b', is.peek(1));
+    ASSERT_EQ('c', is.peek(2));
+    ASSERT_EQ(EOF, is.peek(3));
+    ASSERT_EQ('a', is.get());
+}
+
+TEST(PipelinedInputStream, new_line)
+{
+    klex::PipelinedInputStream is(make_input("a\r\n\rb"));
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ(2, is.get_column());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ(3, is.get_line());
+    ASSERT_EQ(1, is.get_column());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ(2, is.get_column());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(PipelinedInputStream, same_offsets_as_input)
+{
+    // spans several batches, with newlines and ill-formed input in them
+    std::string str;
+    for (int i = 0; i < 1000; ++i)
+    {
+        str += "ab\r\n\xce\xba\xC0\n";
+    }
+    klex::InputStream expected(
+        std::unique_ptr<std::istream>(new std::istringstream(str)));
+    klex::PipelinedInputStream is(make_input(str));
+    int code_point;
+    do
+    {
+        code_point = expected.get();
+        ASSERT_EQ(code_point, is.get());
+        ASSERT_EQ(expected.get_offset(), is.get_offset());
+        ASSERT_EQ(expected.get_line(), is.get_line());
+        ASSERT_EQ(expected.get_column(), is.get_column());
+    } while (code_point != EOF);
+    auto const& invalid = is.get_invalid_sequences();
+    ASSERT_EQ(expected.get_invalid_sequences().size(), invalid.size());
+    for (std::size_t i = 0; i < invalid.size(); ++i)
+    {
+        ASSERT_EQ(expected.get_invalid_sequences()[i].offset,
+                  invalid[i].offset);
+        ASSERT_EQ(expected.get_invalid_sequences()[i].length,
+                  invalid[i].length);
+    }
+}
+
+TEST(PipelinedInputStream, location)
+{
+    klex::LocationTable table;
+    auto file = table.add_file("a.txt", 5);
+    std::unique_ptr<klex::InputStream> input = make_input("a\nbc");
+    input->set_location_table(table, file);
+    klex::PipelinedInputStream is(std::move(input));
+    ASSERT_EQ(table.get_location(file, 0), is.get_location());
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('b', is.get());
+    auto location = is.get_location();
+    ASSERT_EQ(table.get_location(file, 3), location);
+    while (is.get() != EOF)
+    {
+    }
+    ASSERT_EQ(2, table.get_line(location));
+    ASSERT_EQ(2, table.get_column(location));
+}
+
+TEST(PipelinedInputStream, many_batches)
+{
+    int const size = 100000;
+    int const lookahead = 200;
+    std::string str;
+    for (int i = 0; i < size; ++i)
+    {
+        str += static_cast<char>('a' + i % 26);
+    }
+    klex::PipelinedInputStream is(make_input(str));
+    for (int i = 0; i < size; ++i)
+    {
+        int const expected =
+            i + lookahead < size ? 'a' + (i + lookahead) % 26 : EOF;
+        ASSERT_EQ(expected, is.peek(lookahead));
+        ASSERT_EQ('a' + i % 26, is.get());
+    }
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(PipelinedInputStream, early_destruction)
+{
+    klex::PipelinedInputStream is(make_input(std::string(1000000, 'a')));
+    ASSERT_EQ('a', is.get());
+}
+
+TEST(PipelinedInputStream, producer_error)
+{
+    std::unique_ptr<FailingBuffer> buffer{new FailingBuffer};
+    std::unique_ptr<std::istream> stream{new std::istream(buffer.get())};
+    stream->exceptions(std::ios::badbit);
+    klex::PipelinedInputStream is(std::unique_ptr<klex::InputStream>(
+        new klex::InputStream(std::move(stream))));
+    ASSERT_THROW(is.get(), std::runtime_error);
+}
+
+TEST(PipelinedInputStream, slow_producer)
+{
+    std::unique_ptr<SlowBuffer> buffer{new SlowBuffer("abc")};
+    klex::PipelinedInputStream is(std::unique_ptr<klex::InputStream>(
+        new klex::InputStream(std::unique_ptr<std::istream>(
+            new std::istream(buffer.get())))));
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ('c', is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(PipelinedInputStream, bursty_consumer)
+{
+    // Alternates between draining the queue, so that the consumer blocks
+    // on an empty one, and pausing, so that the producer blocks on a full
+    // one. Both sides going to sleep in quick succession must not leave
+    // either of them waiting forever.
+    int const size = 2000000;
+    std::string str;
+    for (int i = 0; i < size; ++i)
+    {
+        str += static_cast<char>('a' + i % 26);
+    }
+    klex::PipelinedInputStream is(make_input(str));
+    unsigned random = 1;
+    int burst = 0;
+    for (int i = 0; i < size; ++i)
+    {
+        if (burst-- == 0)
+        {
+            random = random * 1103515245 + 12345;
+            burst = (random >> 8) % 40000;
+            if (random & 0x10000)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+        ASSERT_EQ('a' + i % 26, is.get());
+    }
+    ASSERT_EQ(EOF, is.get());
+}
@@ -0,0 +1,219 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/InputStream.h"
+#include "../src/SourceCache.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+    class TemporaryFile
+    {
+    public:
+        explicit TemporaryFile(std::string const& contents)
+        {
+            char path[] = "/tmp/klex-XXXXXX";
+            ::close(::mkstemp(path));
+            path_ = path;
+            write(contents);
+        }
+
+        ~TemporaryFile()
+        {
+            std::remove(path_.c_str());
+        }
+
+        void write(std::string const& contents)
+        {
+            std::ofstream os(path_, std::ios::binary);
+            os << contents;
+        }
+
+        void set_mtime(time_t seconds, long nanoseconds)
+        {
+            struct timespec const times[2] = {{seconds, nanoseconds},
+                                              {seconds, nanoseconds}};
+            ::utimensat(AT_FDCWD, path_.c_str(), times, 0);
+        }
+
+        std::string const& path() const
+        {
+            return path_;
+        }
+
+    private:
+        std::string path_;
+    };
+
+    std::shared_ptr<klex::SourceFile const> make_file(std::string const& str)
+    {
+        return std::make_shared<klex::SourceFile>(
+            "test", std::vector<char>(str.begin(), str.end()));
+    }
+
+} // close unnamed namespace
+
+TEST(SourceFile, valid_size)
+{
+    ASSERT_EQ(4u, make_file("ab\xce\xba")->get_valid_size());
+    ASSERT_EQ(2u, make_file("ab\xC0\xAF" "cd")->get_valid_size());
+}
+
+TEST(SourceFile, line_starts)
+{
+    auto file = make_file("a\nb\r\nc\rd\xce\xba\xC0\ne");
+    std::vector<std::uint64_t> expected{2, 4, 6, 10};
+    ASSERT_EQ(expected, file->get_line_starts());
+}
+
+TEST(SourceFile, input_stream)
+{
+    auto file = make_file("a\r\n\xce\xba\xC0" "b");
+    klex::InputStream is(file);
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ(0x03ba, is.get());
+    ASSERT_EQ(0xFFFD, is.get());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ(EOF, is.get());
+    ASSERT_EQ(2, is.get_line());
+}
+
+TEST(SourceFile, input_stream_detect)
+{
+    klex::InputStream is(make_file(std::string("\xFF\xFE" "a\0", 4)),
+                         klex::Encoding::detect);
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(SourceFile, input_stream_resume)
+{
+    klex::InputStream is(make_file("a\nb\nc"));
+    is.set_snapshot_interval(1);
+    while (is.get() != EOF)
+    {
+    }
+    is.resume(make_file("a\nb\nxy"), 4, 1, 2);
+    ASSERT_EQ(2, is.get_line());
+    ASSERT_EQ('b', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ('x', is.get());
+    ASSERT_EQ('y', is.get());
+    ASSERT_EQ(EOF, is.get());
+}
+
+TEST(SourceCache, hit)
+{
+    TemporaryFile tmp("abc");
+    klex::SourceCache cache{1024 * 1024};
+    auto first = cache.get(tmp.path());
+    auto second = cache.get(tmp.path());
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(3u, first->size());
+    ASSERT_EQ(first->get_memory_usage(), cache.get_memory_usage());
+}
+
+TEST(SourceCache, modified_file)
+{
+    TemporaryFile tmp("abc");
+    klex::SourceCache cache{1024 * 1024};
+    auto first = cache.get(tmp.path());
+    tmp.write("abcd");
+    auto second = cache.get(tmp.path());
+    ASSERT_NE(first, second);
+    ASSERT_EQ(4u, second->size());
+    ASSERT_EQ(second->get_memory_usage(), cache.get_memory_usage());
+}
+
+TEST(SourceCache, rewritten_within_a_second)
+{
+    TemporaryFile tmp("abc");
+    tmp.set_mtime(1000000000, 100);
+    klex::SourceCache cache{1024 * 1024};
+    auto first = cache.get(tmp.path());
+    tmp.write("xyz");
+    tmp.set_mtime(1000000000, 200);
+    auto second = cache.get(tmp.path());
+    ASSERT_NE(first, second);
+    ASSERT_EQ("xyz", std::string(second->data(), second->size()));
+}
+
+TEST(SourceCache, eviction)
+{
+    TemporaryFile a("a");
+    TemporaryFile b("b");
+    TemporaryFile c("c");
+    klex::SourceCache cache{1024 * 1024};
+    auto first = cache.get(a.path());
+    cache.get(b.path());
+    cache.get(c.path());
+    cache.get(a.path());
+    std::size_t const usage = cache.get_memory_usage();
+    // leaves room for two files, b being the least recently used one
+    cache.set_memory_budget(usage - 1);
+    ASSERT_EQ(first, cache.get(a.path()));
+    auto evicted = cache.get(b.path());
+    ASSERT_EQ("b", std::string(evicted->data(), evicted->size()));
+    ASSERT_LE(cache.get_memory_usage(), usage - 1);
+}
+
+TEST(SourceCache, concurrent_misses)
+{
+    TemporaryFile tmp(std::string(4 * 1024 * 1024, 'a'));
+    klex::SourceCache cache{64 * 1024 * 1024};
+    std::atomic<bool> start{false};
+    std::vector<std::shared_ptr<klex::SourceFile const>> files(8);
+    std::vector<std::thread> threads;
+    for (auto& file : files)
+    {
+        threads.emplace_back([&]
+        {
+            while (!start)
+            {
+                std::this_thread::yield();
+            }
+            file = cache.get(tmp.path());
+        });
+    }
+    start = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (auto const& file : files)
+    {
+        ASSERT_EQ(files[0], file);
+    }
+    ASSERT_EQ(files[0]->get_memory_usage(), cache.get_memory_usage());
+}
+
+TEST(SourceCache, missing_file)
+{
+    klex::SourceCache cache{1024};
+    ASSERT_THROW(cache.get("/nonexistent/klex/file"), std::runtime_error);
+}
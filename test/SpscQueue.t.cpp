@@ -0,0 +1,74 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/SpscQueue.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(SpscQueue, empty)
+{
+    klex::SpscQueue<int, 4> q;
+    ASSERT_EQ(4u, q.capacity());
+    ASSERT_EQ(nullptr, q.try_front());
+}
+
+TEST(SpscQueue, full)
+{
+    klex::SpscQueue<int, 2> q;
+    *q.try_reserve() = 1;
+    q.commit();
+    *q.try_reserve() = 2;
+    q.commit();
+    ASSERT_EQ(nullptr, q.try_reserve());
+    ASSERT_EQ(1, *q.try_front());
+    q.pop();
+    *q.try_reserve() = 3;
+    q.commit();
+    ASSERT_EQ(2, *q.try_front());
+    q.pop();
+    ASSERT_EQ(3, *q.try_front());
+    q.pop();
+    ASSERT_EQ(nullptr, q.try_front());
+}
+
+TEST(SpscQueue, two_threads)
+{
+    klex::SpscQueue<int, 8> q;
+    int const count = 100000;
+    std::thread producer([&q]
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            int* slot;
+            while (!(slot = q.try_reserve()))
+            {
+                std::this_thread::yield();
+            }
+            *slot = i;
+            q.commit();
+        }
+    });
+    for (int i = 0; i < count; ++i)
+    {
+        int* slot;
+        while (!(slot = q.try_front()))
+        {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(i, *slot);
+        q.pop();
+    }
+    producer.join();
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/Utf16Decoder.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+    std::vector<int> decode_all(klex::Utf16Decoder const& decoder,
+                                std::string const& str)
+    {
+        std::vector<int> result;
+        char const* it = str.data();
+        char const* end = it + str.size();
+        int code_point;
+        while ((code_point = decoder.decode(it, end)) != EOF)
+        {
+            result.push_back(code_point);
+        }
+        return result;
+    }
+
+} // close unnamed namespace
+
+TEST(Utf16Decoder, empty_range)
+{
+    std::string str;
+    char const* it = str.data();
+    klex::Utf16Decoder decoder{false};
+    ASSERT_EQ(EOF, decoder.decode(it, it));
+}
+
+TEST(Utf16Decoder, little_endian)
+{
+    std::string str("a\0\xba\x03\x52\xD8\x62\xDF", 8);
+    std::vector<int> expected{'a', 0x03ba, 0x24b62};
+    ASSERT_EQ(expected, decode_all(klex::Utf16Decoder{false}, str));
+}
+
+TEST(Utf16Decoder, big_endian)
+{
+    std::string str("\0a\x03\xba\xD8\x52\xDF\x62", 8);
+    std::vector<int> expected{'a', 0x03ba, 0x24b62};
+    ASSERT_EQ(expected, decode_all(klex::Utf16Decoder{true}, str));
+}
+
+TEST(Utf16Decoder, unpaired_high_surrogate)
+{
+    std::string str("\xD8\x52\0a\xD8\x52", 6);
+    std::vector<int> expected{0xFFFD, 'a', 0xFFFD};
+    ASSERT_EQ(expected, decode_all(klex::Utf16Decoder{true}, str));
+}
+
+TEST(Utf16Decoder, unpaired_low_surrogate)
+{
+    std::string str("\xDF\x62\0a", 4);
+    std::vector<int> expected{0xFFFD, 'a'};
+    ASSERT_EQ(expected, decode_all(klex::Utf16Decoder{true}, str));
+}
+
+TEST(Utf16Decoder, odd_trailing_byte)
+{
+    std::string str("\0a\0", 3);
+    std::vector<int> expected{'a', 0xFFFD};
+    ASSERT_EQ(expected, decode_all(klex::Utf16Decoder{true}, str));
+}
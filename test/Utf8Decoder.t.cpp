@@ -187,3 +187,83 @@ TEST(Utf8Decoder, invalid_seq_replacement_3)
     ASSERT_EQ(EOF, decoder.decode(is));
 }
 
+TEST(Utf8Decoder, range_invalid_seq_replacement)
+{
+    std::string input_data(
+        "\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64");
+    char const* it = input_data.data();
+    char const* end = it + input_data.size();
+    klex::Utf8Decoder decoder;
+    ASSERT_EQ(0x61, decoder.decode(it, end));
+    ASSERT_EQ(0xFFFD, decoder.decode(it, end));
+    ASSERT_EQ('\xE1', *it);
+    ASSERT_EQ(0xFFFD, decoder.decode(it, end));
+    ASSERT_EQ('\xC2', *it);
+    ASSERT_EQ(0xFFFD, decoder.decode(it, end));
+    ASSERT_EQ(0x62, decoder.decode(it, end));
+    ASSERT_EQ(0xFFFD, decoder.decode(it, end));
+    ASSERT_EQ(0x63, decoder.decode(it, end));
+    ASSERT_EQ(0xFFFD, decoder.decode(it, end));
+    ASSERT_EQ(0xFFFD, decoder.decode(it, end));
+    ASSERT_EQ(0x64, decoder.decode(it, end));
+    ASSERT_EQ(EOF, decoder.decode(it, end));
+}
+
+TEST(Utf8Decoder, range_truncated_seq)
+{
+    std::string input_data("\xF0\x90\x80");
+    char const* it = input_data.data();
+    char const* end = it + input_data.size();
+    klex::Utf8Decoder decoder;
+    ASSERT_EQ(0xFFFD, decoder.decode(it, end));
+    ASSERT_EQ(end, it);
+    ASSERT_EQ(EOF, decoder.decode(it, end));
+}
+
+TEST(Utf8Decoder, decode_unchecked)
+{
+    std::string input_data{'\x61',
+                           '\xce', '\xba',                 // κ
+                           '\xe1', '\xbd', '\xb9',         // ό
+                           '\xf0', '\xa4', '\xad', '\xa2', // ??
+    };
+    char const* it = input_data.data();
+    klex::Utf8Decoder decoder;
+    ASSERT_EQ(0x61, decoder.decode_unchecked(it));
+    ASSERT_EQ(0x03ba, decoder.decode_unchecked(it));
+    ASSERT_EQ(0x1f79, decoder.decode_unchecked(it));
+    ASSERT_EQ(0x24b62, decoder.decode_unchecked(it));
+    ASSERT_EQ(input_data.data() + input_data.size(), it);
+}
+
+TEST(Utf8Decoder, validate_correct_text)
+{
+    std::string input_data("abcdefghijklmnop\xce\xba\xe1\xbd\xb9q"
+                           "\xf0\xa4\xad\xa2\xf4\x8f\xbf\xbf");
+    char const* begin = input_data.data();
+    char const* end = begin + input_data.size();
+    ASSERT_EQ(end, klex::Utf8Decoder::validate(begin, end));
+}
+
+TEST(Utf8Decoder, validate_invalid_text)
+{
+    std::string s1("abcdefghijk\xC0\xAF");
+    ASSERT_EQ(s1.data() + 11,
+              klex::Utf8Decoder::validate(s1.data(), s1.data() + s1.size()));
+    std::string s2("ab\xED\xA0\x80");
+    ASSERT_EQ(s2.data() + 2,
+              klex::Utf8Decoder::validate(s2.data(), s2.data() + s2.size()));
+    std::string s3("ab\xF4\x90\x80\x80");
+    ASSERT_EQ(s3.data() + 2,
+              klex::Utf8Decoder::validate(s3.data(), s3.data() + s3.size()));
+    std::string s4("ab\xE0\x9F\xBF");
+    ASSERT_EQ(s4.data() + 2,
+              klex::Utf8Decoder::validate(s4.data(), s4.data() + s4.size()));
+}
+
+TEST(Utf8Decoder, validate_truncated_text)
+{
+    std::string s("abc\xf0\xa4\xad");
+    ASSERT_EQ(s.data() + 3,
+              klex::Utf8Decoder::validate(s.data(), s.data() + s.size()));
+}
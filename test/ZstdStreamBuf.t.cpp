@@ -0,0 +1,94 @@
+// Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../src/InputStream.h"
+#include "../src/ZstdStreamBuf.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <zstd.h>
+
+namespace
+{
+
+    std::string zstd(std::string const& str)
+    {
+        std::string result(ZSTD_compressBound(str.size()), '\0');
+        result.resize(ZSTD_compress(&result[0], result.size(), str.data(),
+                                    str.size(), 1));
+        return result;
+    }
+
+    std::unique_ptr<std::istream> make_stream(std::string const& str)
+    {
+        return std::unique_ptr<std::istream>(new klex::ZstdStream(
+            std::unique_ptr<std::istream>(new std::istringstream(str))));
+    }
+
+    std::string read_all(std::istream& is)
+    {
+        std::ostringstream os;
+        os << is.rdbuf();
+        return os.str();
+    }
+
+} // close unnamed namespace
+
+TEST(ZstdStreamBuf, bulk_read)
+{
+    std::string str;
+    for (int i = 0; i < 200000; ++i)
+    {
+        str += static_cast<char>('a' + i % 23);
+    }
+    auto is = make_stream(zstd(str));
+    std::string result(str.size() + 10, '\0');
+    is->read(&result[0], result.size());
+    ASSERT_EQ(str.size(), static_cast<std::size_t>(is->gcount()));
+    result.resize(is->gcount());
+    ASSERT_EQ(str, result);
+}
+
+TEST(ZstdStreamBuf, concatenated_frames)
+{
+    auto is = make_stream(zstd("abc") + zstd("def"));
+    ASSERT_EQ("abcdef", read_all(*is));
+}
+
+TEST(ZstdStreamBuf, truncated_input)
+{
+    std::string compressed = zstd("abcdefgh");
+    auto is = make_stream(compressed.substr(0, compressed.size() - 2));
+    char buffer[16];
+    ASSERT_THROW(is->read(buffer, sizeof(buffer)), std::runtime_error);
+}
+
+TEST(ZstdStreamBuf, corrupt_input)
+{
+    auto is = make_stream("definitely not zstd");
+    char buffer[16];
+    ASSERT_THROW(is->read(buffer, sizeof(buffer)), std::runtime_error);
+}
+
+TEST(ZstdStreamBuf, input_stream)
+{
+    klex::InputStream is(make_stream(zstd("a\r\n\xce\xba")));
+    ASSERT_EQ('a', is.get());
+    ASSERT_EQ('\n', is.get());
+    ASSERT_EQ(0x03ba, is.get());
+    ASSERT_EQ(EOF, is.get());
+}
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+# Copyright (C) 2014 Jakub Lewandowski <jakub.lewandowski@gmail.com>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Generates src/NfcTables.cpp from the Unicode database bundled with Python:
+#
+#     tools/gen_nfc_tables.py > src/NfcTables.cpp
+
+import sys
+import unicodedata
+
+MAX_CODE_POINT = 0x10FFFF
+SBASE, SCOUNT = 0xAC00, 11172
+VBASE, VCOUNT = 0x1161, 21
+TBASE, TCOUNT = 0x11A7, 28
+
+LICENSE = (open(__file__).read().split('\n\n')[0]
+           .split('\n', 1)[1].replace('#', '//'))
+
+
+def is_hangul_syllable(cp):
+    return SBASE <= cp < SBASE + SCOUNT
+
+
+def canonical_decomposition(cp):
+    fields = unicodedata.decomposition(chr(cp)).split()
+    if not fields or fields[0].startswith('<'):
+        return None
+    return [int(f, 16) for f in fields]
+
+
+def ranges(values):
+    """Groups (code point, value) pairs into (first, last, value) runs."""
+    result = []
+    for cp, value in sorted(values.items()):
+        if result and result[-1][1] == cp - 1 and result[-1][2] == value:
+            result[-1][1] = cp
+        else:
+            result.append([cp, cp, value])
+    return result
+
+
+def main():
+    combining_classes = {}
+    decompositions = {}
+    compositions = {}
+    for cp in range(MAX_CODE_POINT + 1):
+        if 0xD800 <= cp <= 0xDFFF:
+            continue
+        c = chr(cp)
+        if unicodedata.combining(c):
+            combining_classes[cp] = unicodedata.combining(c)
+        if is_hangul_syllable(cp):
+            continue
+        mapping = canonical_decomposition(cp)
+        if mapping is None:
+            continue
+        decompositions[cp] = [ord(d) for d in unicodedata.normalize('NFD', c)]
+        pair = ''.join(chr(m) for m in mapping)
+        if len(mapping) == 2 and unicodedata.normalize('NFC', pair) == c:
+            compositions[tuple(mapping)] = cp
+
+    # NFC_QC=No: code points that never occur in NFC text
+    # NFC_QC=Maybe: code points that may compose with a preceding one
+    quick_check = {}
+    for first, second in compositions:
+        quick_check[second] = 2
+    for v in range(VBASE, VBASE + VCOUNT):
+        quick_check[v] = 2
+    for t in range(TBASE + 1, TBASE + TCOUNT):
+        quick_check[t] = 2
+    for cp in decompositions:
+        if unicodedata.normalize('NFC', chr(cp)) != chr(cp):
+            quick_check[cp] = 1
+
+    out = sys.stdout
+    out.write(LICENSE + '\n\n')
+    out.write('// Generated by tools/gen_nfc_tables.py from Unicode %s - '
+              'do not edit.\n\n' % unicodedata.unidata_version)
+    out.write('#include "NfcTables.h"\n\n')
+    out.write('namespace klex\n{\n\n    namespace nfc_tables\n    {\n\n')
+
+    def write_ranges(name, values):
+        rs = ranges(values)
+        out.write('        Range const %s[] = {\n' % name)
+        for first, last, value in rs:
+            out.write('            {0x%04X, 0x%04X, %d},\n'
+                      % (first, last, value))
+        out.write('        };\n\n')
+        out.write('        std::size_t const %s_size =\n'
+                  '            sizeof(%s) / sizeof(%s[0]);\n\n'
+                  % (name, name, name))
+
+    write_ranges('combining_classes', combining_classes)
+    write_ranges('quick_check', quick_check)
+
+    data = []
+    out.write('        Decomposition const decompositions[] = {\n')
+    for cp, mapping in sorted(decompositions.items()):
+        out.write('            {0x%04X, %d, %d},\n'
+                  % (cp, len(data), len(mapping)))
+        data.extend(mapping)
+    out.write('        };\n\n')
+    out.write('        std::size_t const decompositions_size =\n'
+              '            sizeof(decompositions) / '
+              'sizeof(decompositions[0]);\n\n')
+    out.write('        int const decomposition_data[] = {\n')
+    for i in range(0, len(data), 8):
+        out.write('            %s,\n'
+                  % ', '.join('0x%04X' % d for d in data[i:i + 8]))
+    out.write('        };\n\n')
+
+    out.write('        Composition const compositions[] = {\n')
+    for (first, second), composite in sorted(compositions.items()):
+        out.write('            {0x%04X, 0x%04X, 0x%04X},\n'
+                  % (first, second, composite))
+    out.write('        };\n\n')
+    out.write('        std::size_t const compositions_size =\n'
+              '            sizeof(compositions) / sizeof(compositions[0]);\n\n')
+
+    out.write('    } // close nfc_tables namespace\n\n'
+              '} // close klex namespace\n')
+
+
+if __name__ == '__main__':
+    main()